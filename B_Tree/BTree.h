@@ -0,0 +1,756 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+
+//B+tree engine taking the same traits as RBTree (MapTraits, SetTraits).
+//keys are packed in cache-line-aligned nodes of about NodeBytes bytes, so
+//one node visit replaces several levels of a binary tree; values live only
+//in the leaves, which are linked, so in-order scans are sequential.
+template<class Traits, size_t NodeBytes = 256>
+class BTree
+{
+public:
+	using KeyType		  = typename Traits::key;
+	using ValueType		  = typename Traits::value;
+	using key_compare     = typename Traits::key_compare;
+	using allocator_type  = typename Traits::allocator_type;
+	using reference		  = ValueType&;
+	using const_reference = const ValueType&;
+
+	class Iterator;
+	class Const_Iterator;
+
+	using iterator = std::conditional_t<std::is_same_v<KeyType, ValueType>, Const_Iterator, Iterator>;
+
+protected:
+	static constexpr size_t capacity = std::max<size_t>(4, NodeBytes / sizeof(KeyType));
+	static constexpr size_t min_fill = capacity / 2;
+
+	struct alignas(64) NodeBase
+	{
+		bool is_leaf;
+		size_t count = 0;		//keys in the node
+
+		explicit NodeBase(bool is_leaf) : is_leaf(is_leaf) { }
+	};
+
+	//one spare slot in every array lets a node overflow by one before it is split
+	struct Leaf : NodeBase
+	{
+		Leaf* prev = nullptr;
+		Leaf* next = nullptr;
+		KeyType keys[capacity + 1];
+		alignas(ValueType) unsigned char storage[(capacity + 1) * sizeof(ValueType)];
+
+		Leaf() : NodeBase(true) { }
+
+		ValueType* values() { return std::launder(reinterpret_cast<ValueType*>(storage)); }
+
+		const ValueType* values() const { return std::launder(reinterpret_cast<const ValueType*>(storage)); }
+	};
+
+	struct Internal : NodeBase
+	{
+		KeyType keys[capacity + 1];		//keys[i] is the smallest key under children[i + 1]
+		NodeBase* children[capacity + 2];
+
+		Internal() : NodeBase(false) { }
+	};
+
+	using leaf_allocator	 = typename std::allocator_traits<allocator_type>::template rebind_alloc<Leaf>;
+	using internal_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<Internal>;
+
+	key_compare comp;
+	leaf_allocator leaf_alloc;
+	internal_allocator internal_alloc;
+
+	NodeBase* root = nullptr;
+	Leaf* head = nullptr;		//leftmost leaf
+	Leaf* tail = nullptr;		//rightmost leaf
+	size_t _size = 0;
+	size_t height = 0;			//number of levels, leaves included
+
+public:
+
+	BTree()
+	{
+	}
+
+	explicit BTree(const allocator_type& alloc) : leaf_alloc(alloc), internal_alloc(alloc)
+	{
+	}
+
+	BTree(const BTree&) = delete;
+
+	BTree& operator=(const BTree&) = delete;
+
+	~BTree()
+	{
+		destroy(root);
+	}
+
+	allocator_type get_allocator() const { return allocator_type(leaf_alloc); }
+
+	bool erase(const KeyType& key)
+	{
+		if (root == nullptr) return false;
+
+		Internal* path[std::numeric_limits<size_t>::digits];
+		size_t slots[std::numeric_limits<size_t>::digits];
+		Leaf* leaf = descend(key, path, slots);
+		size_t pos = leafPosition(leaf, key);
+		if (pos == leaf->count || comp(key, leaf->keys[pos])) {
+			return false;
+		}
+
+		removeFromLeaf(leaf, pos);
+		--_size;
+		rebalanceLeaf(leaf, path, slots, height - 1);
+		return true;
+	}
+
+	void clear()
+	{
+		destroy(root);
+		root = nullptr;
+		head = tail = nullptr;
+		_size = 0;
+		height = 0;
+	}
+
+	bool empty() const { return _size == 0; }
+
+	size_t size() const { return _size; }
+
+	size_t max_size() const { return std::numeric_limits<ptrdiff_t>::max(); }
+
+	size_t count(const KeyType& key) const
+	{
+		return contains(key) ? 1 : 0;
+	}
+
+	bool contains(const KeyType& key) const
+	{
+		if (root == nullptr) return false;
+		Leaf* leaf = descend(key);
+		size_t pos = leafPosition(leaf, key);
+		return pos < leaf->count && !comp(key, leaf->keys[pos]);
+	}
+
+	iterator find(const KeyType& key)
+	{
+		if (root == nullptr) return end();
+		Leaf* leaf = descend(key);
+		size_t pos = leafPosition(leaf, key);
+		if (pos == leaf->count || comp(key, leaf->keys[pos])) {
+			return end();
+		}
+		return iterator(leaf, pos, this);
+	}
+
+	//first element not less than key
+	iterator lower_bound(const KeyType& key)
+	{
+		if (root == nullptr) return end();
+		Leaf* leaf = descend(key);
+		return normalized(leaf, leafPosition(leaf, key));
+	}
+
+	//first element greater than key
+	iterator upper_bound(const KeyType& key)
+	{
+		if (root == nullptr) return end();
+		Leaf* leaf = descend(key);
+		size_t pos = std::upper_bound(leaf->keys, leaf->keys + leaf->count, key, comp) - leaf->keys;
+		return normalized(leaf, pos);
+	}
+
+protected:
+	ValueType* search(const KeyType& key)
+	{
+		if (root == nullptr) return nullptr;
+		Leaf* leaf = descend(key);
+		size_t pos = leafPosition(leaf, key);
+		if (pos == leaf->count || comp(key, leaf->keys[pos])) {
+			return nullptr;
+		}
+		return &leaf->values()[pos];
+	}
+
+	std::pair<iterator, bool> insert(const ValueType& value)
+	{
+		return insertUnique(Traits::get_key(value), value);
+	}
+
+	//builds the element from args only once key is known to be absent
+	template<class... Args>
+	std::pair<iterator, bool> insertUnique(const KeyType& key, Args&&... args)
+	{
+		if (root == nullptr) {
+			Leaf* leaf = createLeaf();
+			root = head = tail = leaf;
+			height = 1;
+		}
+
+		Internal* path[std::numeric_limits<size_t>::digits];
+		size_t slots[std::numeric_limits<size_t>::digits];
+		Leaf* leaf = descend(key, path, slots);
+		size_t pos = leafPosition(leaf, key);
+		if (pos < leaf->count && !comp(key, leaf->keys[pos])) {
+			return std::make_pair(iterator(leaf, pos, this), false);
+		}
+
+		insertIntoLeaf(leaf, pos, key, std::forward<Args>(args)...);
+		++_size;
+		if (leaf->count <= capacity) {
+			return std::make_pair(iterator(leaf, pos, this), true);
+		}
+
+		//overflow: split and push the separator up the recorded path
+		Leaf* right = splitLeaf(leaf);
+		iterator result = pos < leaf->count ? iterator(leaf, pos, this)
+											: iterator(right, pos - leaf->count, this);
+		KeyType separator = right->keys[0];
+		NodeBase* new_child = right;
+		for (size_t level = height - 1; level-- > 0;) {
+			Internal* parent = path[level];
+			insertIntoInternal(parent, slots[level], separator, new_child);
+			if (parent->count <= capacity) {
+				return std::make_pair(result, true);
+			}
+			new_child = splitInternal(parent, separator);
+		}
+
+		//the root itself was split
+		Internal* new_root = createInternal();
+		new_root->keys[0] = separator;
+		new_root->children[0] = root;
+		new_root->children[1] = new_child;
+		new_root->count = 1;
+		root = new_root;
+		++height;
+		return std::make_pair(result, true);
+	}
+
+	//copies the shape of other node for node, O(n), into an empty tree
+	void cloneFrom(const BTree& other)
+	{
+		if (other.root == nullptr) return;
+		Leaf* last_leaf = nullptr;
+		try {
+			root = cloneNode(other.root, last_leaf);
+		}
+		catch (...) {
+			head = nullptr;
+			throw;
+		}
+		tail = last_leaf;
+		_size = other._size;
+		height = other.height;
+	}
+
+public:
+
+	class Iterator
+	{
+		friend class BTree;
+	private:
+		Leaf* leaf = nullptr;
+		size_t index = 0;
+		BTree* tree = nullptr;
+	public:
+		Iterator() { }
+
+		Iterator(Leaf* leaf, size_t index, BTree* tree) : leaf(leaf), index(index), tree(tree) { }
+
+		bool operator==(const Iterator& other) const { return other.leaf == leaf && other.index == index; }
+
+		bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+		Iterator& operator++()
+		{
+			if (++index == leaf->count) {
+				leaf = leaf->next;
+				index = 0;
+			}
+			return *this;
+		}
+
+		Iterator& operator--()
+		{
+			if (leaf == nullptr) {
+				leaf = tree->tail;
+				index = leaf->count - 1;
+			}
+			else if (index == 0) {
+				leaf = leaf->prev;
+				index = leaf->count - 1;
+			}
+			else {
+				--index;
+			}
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			auto it = *this;
+			++*this;
+			return it;
+		}
+
+		Iterator operator--(int)
+		{
+			auto it = *this;
+			--*this;
+			return it;
+		}
+
+		reference operator*() const { return leaf->values()[index]; }
+
+		ValueType* operator->() const { return &leaf->values()[index]; }
+	};
+
+	class Const_Iterator
+	{
+		friend class BTree;
+	private:
+		Leaf* leaf = nullptr;
+		size_t index = 0;
+		const BTree* tree = nullptr;
+	public:
+		Const_Iterator() { }
+
+		Const_Iterator(Leaf* leaf, size_t index, const BTree* tree) : leaf(leaf), index(index), tree(tree) { }
+
+		bool operator==(const Const_Iterator& other) const { return other.leaf == leaf && other.index == index; }
+
+		bool operator!=(const Const_Iterator& other) const { return !(*this == other); }
+
+		Const_Iterator& operator++()
+		{
+			if (++index == leaf->count) {
+				leaf = leaf->next;
+				index = 0;
+			}
+			return *this;
+		}
+
+		Const_Iterator& operator--()
+		{
+			if (leaf == nullptr) {
+				leaf = tree->tail;
+				index = leaf->count - 1;
+			}
+			else if (index == 0) {
+				leaf = leaf->prev;
+				index = leaf->count - 1;
+			}
+			else {
+				--index;
+			}
+			return *this;
+		}
+
+		Const_Iterator operator++(int)
+		{
+			auto it = *this;
+			++*this;
+			return it;
+		}
+
+		Const_Iterator operator--(int)
+		{
+			auto it = *this;
+			--*this;
+			return it;
+		}
+
+		const_reference operator*() const { return leaf->values()[index]; }
+
+		const ValueType* operator->() const { return &leaf->values()[index]; }
+	};
+
+	iterator begin() { return iterator(_size ? head : nullptr, 0, this); }
+
+	iterator end() { return iterator(nullptr, 0, this); }
+
+	Const_Iterator begin() const { return cbegin(); }
+
+	Const_Iterator end() const { return cend(); }
+
+	Const_Iterator cbegin() const { return Const_Iterator(_size ? head : nullptr, 0, this); }
+
+	Const_Iterator cend() const { return Const_Iterator(nullptr, 0, this); }
+
+private:
+	iterator normalized(Leaf* leaf, size_t pos)
+	{
+		if (pos == leaf->count) {
+			return iterator(leaf->next, 0, this);
+		}
+		return iterator(leaf, pos, this);
+	}
+
+	size_t leafPosition(Leaf* leaf, const KeyType& key) const
+	{
+		return std::lower_bound(leaf->keys, leaf->keys + leaf->count, key, comp) - leaf->keys;
+	}
+
+	//child to follow: the number of separators not greater than key
+	size_t childSlot(Internal* node, const KeyType& key) const
+	{
+		return std::upper_bound(node->keys, node->keys + node->count, key, comp) - node->keys;
+	}
+
+	Leaf* descend(const KeyType& key) const
+	{
+		NodeBase* node = root;
+		while (!node->is_leaf) {
+			Internal* internal = static_cast<Internal*>(node);
+			node = internal->children[childSlot(internal, key)];
+		}
+		return static_cast<Leaf*>(node);
+	}
+
+	//same, remembering the internal nodes and child slots on the way down
+	Leaf* descend(const KeyType& key, Internal** path, size_t* slots)
+	{
+		NodeBase* node = root;
+		for (size_t level = 0; !node->is_leaf; ++level) {
+			Internal* internal = static_cast<Internal*>(node);
+			path[level] = internal;
+			slots[level] = childSlot(internal, key);
+			node = internal->children[slots[level]];
+		}
+		return static_cast<Leaf*>(node);
+	}
+
+	//***********leaf element moves*******************//
+	//values are not assignable for maps (pair<const K, V>), so they are
+	//relocated: move-constructed into the new slot and destroyed in the old one
+
+	static void relocate(ValueType* from, ValueType* to)
+	{
+		::new (static_cast<void*>(to)) ValueType(std::move(*from));
+		from->~ValueType();
+	}
+
+	template<class... Args>
+	void insertIntoLeaf(Leaf* leaf, size_t pos, const KeyType& key, Args&&... args)
+	{
+		ValueType* values = leaf->values();
+		for (size_t i = leaf->count; i > pos; --i) {
+			relocate(values + i - 1, values + i);
+		}
+		::new (static_cast<void*>(values + pos)) ValueType(std::forward<Args>(args)...);
+		std::move_backward(leaf->keys + pos, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+		leaf->keys[pos] = key;
+		++leaf->count;
+	}
+
+	void removeFromLeaf(Leaf* leaf, size_t pos)
+	{
+		ValueType* values = leaf->values();
+		values[pos].~ValueType();
+		for (size_t i = pos + 1; i < leaf->count; ++i) {
+			relocate(values + i, values + i - 1);
+		}
+		std::move(leaf->keys + pos + 1, leaf->keys + leaf->count, leaf->keys + pos);
+		--leaf->count;
+	}
+
+	//move count elements from the front of src to the back of dst
+	void moveLeafPrefix(Leaf* src, Leaf* dst, size_t count)
+	{
+		ValueType* from = src->values();
+		ValueType* to = dst->values();
+		for (size_t i = 0; i < count; ++i) {
+			relocate(from + i, to + dst->count + i);
+		}
+		for (size_t i = count; i < src->count; ++i) {
+			relocate(from + i, from + i - count);
+		}
+		std::move(src->keys, src->keys + count, dst->keys + dst->count);
+		std::move(src->keys + count, src->keys + src->count, src->keys);
+		dst->count += count;
+		src->count -= count;
+	}
+
+	//move count elements from the back of src to the front of dst
+	void moveLeafSuffix(Leaf* src, Leaf* dst, size_t count)
+	{
+		ValueType* from = src->values();
+		ValueType* to = dst->values();
+		for (size_t i = dst->count; i-- > 0;) {
+			relocate(to + i, to + i + count);
+		}
+		for (size_t i = 0; i < count; ++i) {
+			relocate(from + src->count - count + i, to + i);
+		}
+		std::move_backward(dst->keys, dst->keys + dst->count, dst->keys + dst->count + count);
+		std::move(src->keys + src->count - count, src->keys + src->count, dst->keys);
+		dst->count += count;
+		src->count -= count;
+	}
+
+	Leaf* splitLeaf(Leaf* leaf)
+	{
+		Leaf* right = createLeaf();
+		moveLeafSuffix(leaf, right, leaf->count / 2);
+		right->next = leaf->next;
+		right->prev = leaf;
+		if (leaf->next) leaf->next->prev = right;
+		else tail = right;
+		leaf->next = right;
+		return right;
+	}
+
+	//***********internal node moves*******************//
+
+	void insertIntoInternal(Internal* node, size_t slot, const KeyType& separator, NodeBase* right_child)
+	{
+		std::move_backward(node->keys + slot, node->keys + node->count, node->keys + node->count + 1);
+		std::move_backward(node->children + slot + 1, node->children + node->count + 1, node->children + node->count + 2);
+		node->keys[slot] = separator;
+		node->children[slot + 1] = right_child;
+		++node->count;
+	}
+
+	//remove keys[slot] and children[slot + 1]
+	void removeFromInternal(Internal* node, size_t slot)
+	{
+		std::move(node->keys + slot + 1, node->keys + node->count, node->keys + slot);
+		std::move(node->children + slot + 2, node->children + node->count + 1, node->children + slot + 1);
+		--node->count;
+	}
+
+	//the middle key moves up into separator, the upper half into a new node
+	Internal* splitInternal(Internal* node, KeyType& separator)
+	{
+		Internal* right = createInternal();
+		size_t mid = node->count / 2;
+		separator = std::move(node->keys[mid]);
+		right->count = node->count - mid - 1;
+		std::move(node->keys + mid + 1, node->keys + node->count, right->keys);
+		std::copy(node->children + mid + 1, node->children + node->count + 1, right->children);
+		node->count = mid;
+		return right;
+	}
+
+	//***********underflow repair*******************//
+
+	void rebalanceLeaf(Leaf* leaf, Internal** path, size_t* slots, size_t depth)
+	{
+		if (depth == 0) {		//the leaf is the root
+			if (leaf->count == 0) {
+				destroyLeaf(leaf);
+				root = nullptr;
+				head = tail = nullptr;
+				height = 0;
+			}
+			return;
+		}
+		if (leaf->count >= min_fill) return;
+
+		Internal* parent = path[depth - 1];
+		size_t slot = slots[depth - 1];
+		Leaf* left = slot > 0 ? static_cast<Leaf*>(parent->children[slot - 1]) : nullptr;
+		Leaf* right = slot < parent->count ? static_cast<Leaf*>(parent->children[slot + 1]) : nullptr;
+
+		if (left && left->count > min_fill) {
+			moveLeafSuffix(left, leaf, 1);
+			parent->keys[slot - 1] = leaf->keys[0];
+			return;
+		}
+		if (right && right->count > min_fill) {
+			moveLeafPrefix(right, leaf, 1);
+			parent->keys[slot] = right->keys[0];
+			return;
+		}
+
+		//merge with a sibling, the right node of the pair is freed
+		if (left) {
+			moveLeafPrefix(leaf, left, leaf->count);
+			unlinkLeaf(leaf);
+			destroyLeaf(leaf);
+			removeFromInternal(parent, slot - 1);
+		}
+		else {
+			moveLeafPrefix(right, leaf, right->count);
+			unlinkLeaf(right);
+			destroyLeaf(right);
+			removeFromInternal(parent, slot);
+		}
+		rebalanceInternal(path, slots, depth - 1);
+	}
+
+	void rebalanceInternal(Internal** path, size_t* slots, size_t depth)
+	{
+		Internal* node = path[depth];
+		if (depth == 0) {		//the node is the root
+			if (node->count == 0) {
+				root = node->children[0];
+				destroyInternal(node);
+				--height;
+			}
+			return;
+		}
+		if (node->count >= min_fill) return;
+
+		Internal* parent = path[depth - 1];
+		size_t slot = slots[depth - 1];
+		Internal* left = slot > 0 ? static_cast<Internal*>(parent->children[slot - 1]) : nullptr;
+		Internal* right = slot < parent->count ? static_cast<Internal*>(parent->children[slot + 1]) : nullptr;
+
+		if (left && left->count > min_fill) {
+			//rotate through the parent separator
+			std::move_backward(node->keys, node->keys + node->count, node->keys + node->count + 1);
+			std::move_backward(node->children, node->children + node->count + 1, node->children + node->count + 2);
+			node->keys[0] = std::move(parent->keys[slot - 1]);
+			node->children[0] = left->children[left->count];
+			parent->keys[slot - 1] = std::move(left->keys[left->count - 1]);
+			--left->count;
+			++node->count;
+			return;
+		}
+		if (right && right->count > min_fill) {
+			node->keys[node->count] = std::move(parent->keys[slot]);
+			node->children[node->count + 1] = right->children[0];
+			parent->keys[slot] = std::move(right->keys[0]);
+			std::move(right->keys + 1, right->keys + right->count, right->keys);
+			std::move(right->children + 1, right->children + right->count + 1, right->children);
+			--right->count;
+			++node->count;
+			return;
+		}
+
+		if (left) {
+			mergeInternal(left, node, parent, slot - 1);
+		}
+		else {
+			mergeInternal(node, right, parent, slot);
+		}
+		rebalanceInternal(path, slots, depth - 1);
+	}
+
+	//append parent->keys[slot] and all of right to left, then free right
+	void mergeInternal(Internal* left, Internal* right, Internal* parent, size_t slot)
+	{
+		left->keys[left->count] = std::move(parent->keys[slot]);
+		std::move(right->keys, right->keys + right->count, left->keys + left->count + 1);
+		std::copy(right->children, right->children + right->count + 1, left->children + left->count + 1);
+		left->count += right->count + 1;
+		destroyInternal(right);
+		removeFromInternal(parent, slot);
+	}
+
+	void unlinkLeaf(Leaf* leaf)
+	{
+		if (leaf->prev) leaf->prev->next = leaf->next;
+		else head = leaf->next;
+		if (leaf->next) leaf->next->prev = leaf->prev;
+		else tail = leaf->prev;
+	}
+
+	//***********copying*******************//
+
+	//clone of the subtree under node; its leaves are appended to the leaf
+	//list after last_leaf, which then points at the last of them.
+	//a partial copy is freed if a value copy throws
+	NodeBase* cloneNode(const NodeBase* node, Leaf*& last_leaf)
+	{
+		if (node->is_leaf) {
+			const Leaf* source = static_cast<const Leaf*>(node);
+			Leaf* leaf = createLeaf();
+			try {
+				for (size_t i = 0; i < source->count; ++i) {
+					::new (static_cast<void*>(leaf->values() + i)) ValueType(source->values()[i]);
+					leaf->keys[i] = source->keys[i];
+					++leaf->count;
+				}
+			}
+			catch (...) {
+				destroyLeaf(leaf);
+				throw;
+			}
+			leaf->prev = last_leaf;
+			if (last_leaf) last_leaf->next = leaf;
+			else head = leaf;
+			last_leaf = leaf;
+			return leaf;
+		}
+
+		const Internal* source = static_cast<const Internal*>(node);
+		Internal* internal = createInternal();
+		size_t cloned = 0;
+		try {
+			for (; cloned <= source->count; ++cloned) {
+				internal->children[cloned] = cloneNode(source->children[cloned], last_leaf);
+			}
+		}
+		catch (...) {
+			for (size_t i = 0; i < cloned; ++i) {
+				destroy(internal->children[i]);
+			}
+			destroyInternal(internal);
+			throw;
+		}
+		std::copy(source->keys, source->keys + source->count, internal->keys);
+		internal->count = source->count;
+		return internal;
+	}
+
+	//***********node allocation*******************//
+
+	Leaf* createLeaf()
+	{
+		Leaf* leaf = std::allocator_traits<leaf_allocator>::allocate(leaf_alloc, 1);
+		return ::new (static_cast<void*>(leaf)) Leaf();
+	}
+
+	Internal* createInternal()
+	{
+		Internal* node = std::allocator_traits<internal_allocator>::allocate(internal_alloc, 1);
+		return ::new (static_cast<void*>(node)) Internal();
+	}
+
+	void destroyLeaf(Leaf* leaf)
+	{
+		ValueType* values = leaf->values();
+		for (size_t i = 0; i < leaf->count; ++i) {
+			values[i].~ValueType();
+		}
+		leaf->~Leaf();
+		std::allocator_traits<leaf_allocator>::deallocate(leaf_alloc, leaf, 1);
+	}
+
+	void destroyInternal(Internal* node)
+	{
+		node->~Internal();
+		std::allocator_traits<internal_allocator>::deallocate(internal_alloc, node, 1);
+	}
+
+	void destroy(NodeBase* node)
+	{
+		if (node == nullptr) return;
+		if (node->is_leaf) {
+			destroyLeaf(static_cast<Leaf*>(node));
+			return;
+		}
+		Internal* internal = static_cast<Internal*>(node);
+		for (size_t i = 0; i <= internal->count; ++i) {
+			destroy(internal->children[i]);
+		}
+		destroyInternal(internal);
+	}
+
+};
@@ -2,12 +2,22 @@
 #define DEQUE_H
 
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <functional>
+#include <span>
+#include <type_traits>
 
 template<class T>
 class deque
 {
 public:
-    class iterator;
+    template<bool Const>
+    class basic_iterator;
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
 private:
 
     static constexpr size_t initial_map_size = 8;
@@ -16,34 +26,52 @@ private:
     size_t map_size;
 
     static constexpr size_t bytes = sizeof(T);
-    static constexpr size_t block_size = bytes <= 1 ? 16	//size of one block(chunk)
-                                       : bytes <= 2 ? 8
-                                       : bytes <= 4 ? 4
-                                       : bytes <= 8 ? 2
-                                       : 1;
+    static constexpr size_t block_bytes = 512;
+    //  size of one block(chunk), big enough for the inner loops
+    //  of the segmented algorithms to be worth vectorizing
+    static constexpr size_t block_size = bytes < block_bytes ? block_bytes / bytes : 1;
     size_t _size; //current length of sequence
 
     iterator start;
     iterator finish;
 public:
-    class iterator
+    //  iterator and const_iterator differ only in what they hand out,
+    //  both walk the same T** map
+    template<bool Const>
+    class basic_iterator
     {
         friend class deque;
+        friend class basic_iterator<!Const>;
     private:
-        T** node; //pointer to current chunk
-        T* curr;
-        T* first;	//first and last elements in current chunk
-        T* last;
+        T** node = nullptr; //pointer to current chunk
+        T* curr = nullptr;
+        T* first = nullptr;	//first and last elements in current chunk
+        T* last = nullptr;
 
     public:
-        iterator() = default;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        basic_iterator() = default;
 
-        iterator(const iterator& x) : curr(x.curr), first(x.first), last(x.last), node(x.node) {}
+        basic_iterator(T* x, T** map_pointer)
+            : node(map_pointer), curr(x), first(*map_pointer), last(*map_pointer + block_size) {}
 
-        iterator(T* x, T** map_pointer)
-            : curr(x), first(*map_pointer), last(*map_pointer + block_size), node(map_pointer) {}
+        //  iterator converts to const_iterator, not the other way round
+        operator basic_iterator<true>() const requires (!Const)
+        {
+            basic_iterator<true> it;
+            it.node = node;
+            it.curr = curr;
+            it.first = first;
+            it.last = last;
+            return it;
+        }
 
-        iterator& operator++()
+        basic_iterator& operator++()
         {
             ++curr;
             if (curr == last) {
@@ -53,61 +81,107 @@ public:
             return *this;
         }
 
-        iterator& operator--()
+        basic_iterator& operator--()
         {
             if (curr == first) {
                 set_node(node - 1);
                 curr = last;
             }
-            else {
-                --curr;
-            }
+            --curr;
             return *this;
         }
 
-        iterator& operator+=(ptrdiff_t n)
+        basic_iterator operator++(int)
+        {
+            auto temp = *this;
+            ++*this;
+            return temp;
+        }
+
+        basic_iterator operator--(int)
+        {
+            auto temp = *this;
+            --*this;
+            return temp;
+        }
+
+        basic_iterator& operator+=(ptrdiff_t n)
         {
-            ptrdiff_t offset = n + curr - first;
+            ptrdiff_t offset = n + (curr - first);
 
-            if (offset >= 0 && offset <= block_size) {		//if it in the same chunk
-                curr += offset;
+            if (offset >= 0 && offset < ptrdiff_t(block_size)) {		//if it in the same chunk
+                curr += n;
             }
             else {
-                ptrdiff_t node_offset;
-                if (offset > 0) {
-                    node_offset = offset / block_size;
-                }
-                else {
-                    node_offset = (offset + 1) / block_size - 1;
-                }
+                //  floor division, so negative offsets land in earlier chunks
+                ptrdiff_t node_offset = offset > 0 ? offset / ptrdiff_t(block_size)
+                                                   : -((-offset - 1) / ptrdiff_t(block_size)) - 1;
 
                 set_node(node + node_offset);
 
-                curr = first + (offset - node_offset * block_size);
+                curr = first + (offset - node_offset * ptrdiff_t(block_size));
             }
             return *this;
         }
 
-        iterator operator+(ptrdiff_t n) const
+        basic_iterator& operator-=(ptrdiff_t n)
+        {
+            return *this += -n;
+        }
+
+        basic_iterator operator+(ptrdiff_t n) const
         {
             auto temp = *this;
             return temp += n;
         }
 
-        iterator operator-(ptrdiff_t n) const
+        basic_iterator operator-(ptrdiff_t n) const
         {
             auto temp = *this;
             return temp += -n;
         }
 
-        T& operator[](size_t index)
+        friend basic_iterator operator+(ptrdiff_t n, const basic_iterator& it)
+        {
+            return it + n;
+        }
+
+        reference operator[](ptrdiff_t index) const
         {
             return *(*this + index);
         }
 
-        T& operator*() { return *curr; }
+        reference operator*() const { return *curr; }
+
+        pointer operator->() const { return curr; }
+
+        //  the rest are hidden friends, so that with the conversion above
+        //  iterators and const_iterators subtract and compare with each other
+
+        //  O(1): whole chunks between the two plus the partial ends
+        friend ptrdiff_t operator-(const basic_iterator& a, const basic_iterator& b)
+        {
+            if (a.node == b.node) {
+                return a.curr - b.curr;
+            }
+            return ptrdiff_t(block_size) * (a.node - b.node - 1)
+                 + (a.curr - a.first) + (b.last - b.curr);
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.curr == b.curr; }
+
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b) { return a.curr != b.curr; }
+
+        friend bool operator<(const basic_iterator& a, const basic_iterator& b)
+        {
+            return a.node == b.node ? a.curr < b.curr : a.node < b.node;
+        }
+
+        friend bool operator>(const basic_iterator& a, const basic_iterator& b) { return b < a; }
 
-        bool operator!=(const iterator& other) { return other.curr != curr; }
+        friend bool operator<=(const basic_iterator& a, const basic_iterator& b) { return !(b < a); }
+
+        friend bool operator>=(const basic_iterator& a, const basic_iterator& b) { return !(a < b); }
 
     private:
         void set_node(T** new_node)
@@ -118,33 +192,132 @@ public:
         }
     };
 
+    //  iterates over the blocks of a deque, yielding each one
+    //  as a contiguous span of the elements it holds.
+    template<bool Const>
+    class basic_segment_iterator
+    {
+        friend class deque;
+    private:
+        using element = std::conditional_t<Const, const T, T>;
+
+        T** node = nullptr;
+        const deque* owner = nullptr;
+
+        basic_segment_iterator(T** node, const deque* owner) : node(node), owner(owner) {}
+
+    public:
+        basic_segment_iterator() = default;
+
+        std::span<element> operator*() const
+        {
+            T* first = (node == owner->start.node) ? owner->start.curr : *node;
+            T* last = (node == owner->finish.node) ? owner->finish.curr : *node + block_size;
+            return std::span<element>(first, last);
+        }
+
+        basic_segment_iterator& operator++() { ++node; return *this; }
+
+        bool operator==(const basic_segment_iterator& other) const { return node == other.node; }
+
+        bool operator!=(const basic_segment_iterator& other) const { return node != other.node; }
+
+        //  iterator into the deque for an element of the current segment
+        basic_iterator<Const> position(element* x) const { return basic_iterator<Const>(const_cast<T*>(x), node); }
+    };
+
+    using segment_iterator = basic_segment_iterator<false>;
+    using const_segment_iterator = basic_segment_iterator<true>;
+
+    template<bool Const>
+    class basic_segment_range
+    {
+        friend class deque;
+    private:
+        basic_segment_iterator<Const> first;
+        basic_segment_iterator<Const> last;
+
+        basic_segment_range(basic_segment_iterator<Const> first, basic_segment_iterator<Const> last) : first(first), last(last) {}
+
+    public:
+        basic_segment_iterator<Const> begin() const { return first; }
+
+        basic_segment_iterator<Const> end() const { return last; }
+    };
+
+    using segment_range = basic_segment_range<false>;
+    using const_segment_range = basic_segment_range<true>;
+
 public:
     deque() : map(nullptr), _size(0), map_size(0)
     {
         create_map_and_nodes(0);
     }
 
-    ~deque()
+    deque(const deque& other) : deque()
     {
-        for (T** node = start.node; node <= finish.node; ++node) {
-            delete[] *node;
+        if (other.empty()) return;
+        for (T** node = other.start.node; node <= other.finish.node; ++node) {
+            T* first = (node == other.start.node) ? other.start.curr : *node;
+            T* last = (node == other.finish.node) ? other.finish.curr : *node + block_size;
+            append(first, last);
         }
-        delete[] map;
     }
 
-    void push_back(const T& value) {
+    //  takes over the map and blocks of other, which is left empty
+    //  and without a map until its next insertion allocates one
+    deque(deque&& other) noexcept
+        : map(other.map), map_size(other.map_size), _size(other._size),
+          start(other.start), finish(other.finish)
+    {
+        other.map = nullptr;
+        other.map_size = 0;
+        other._size = 0;
+        other.start = iterator();
+        other.finish = iterator();
+    }
+
+    deque& operator=(deque other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~deque()
+    {
+        destroy_blocks();
+    }
+
+    void swap(deque& other) noexcept
+    {
+        std::swap(map, other.map);
+        std::swap(map_size, other.map_size);
+        std::swap(_size, other._size);
+        std::swap(start, other.start);
+        std::swap(finish, other.finish);
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    template<class... Args>
+    T& emplace_back(Args&&... args) {
+        ensure_map();
+        T* slot = finish.curr;
         //  check if there is the enough memory to insert element
         if (finish.curr != finish.last - 1) {
-            //  directly constructor.
-            *finish.curr = value;
+            //  directly assign into the constructed slot.
+            assign_slot(*slot, std::forward<Args>(args)...);
             //  adjust the finish map iterator.
             ++finish.curr;
         }
         else {
             //  the special push back version.
-            push_back_aux(value);
+            push_back_aux(std::forward<Args>(args)...);
         }
         ++_size;
+        return *slot;
     }
 
     void pop_back() {
@@ -153,6 +326,7 @@ public:
                 --finish.curr;
             }
             else {
+                delete[] *finish.node;
                 finish.set_node(finish.node - 1);
                 finish.curr = finish.last - 1;
             }
@@ -160,21 +334,34 @@ public:
         }
     }
 
-    void push_front(const T& value)
+    void push_front(const T& value) { emplace_front(value); }
+
+    void push_front(T&& value) { emplace_front(std::move(value)); }
+
+    template<class... Args>
+    T& emplace_front(Args&&... args)
     {
+        ensure_map();
         if (start.curr != start.first) {
+            assign_slot(*(start.curr - 1), std::forward<Args>(args)...);
             --start.curr;
-            *start.curr = value;
         }
         else {
-            T t_copy = value;
             reserve_map_at_front();
-            *(start.node - 1) = new T[block_size];
+            T* block = new T[block_size];
+            try {
+                assign_slot(block[block_size - 1], std::forward<Args>(args)...);
+            }
+            catch (...) {
+                delete[] block;
+                throw;
+            }
+            *(start.node - 1) = block;
             start.set_node(start.node - 1);
             start.curr = start.last - 1;
-            *start.curr = t_copy;
         }
         ++_size;
+        return *start.curr;
     }
 
     void pop_front()
@@ -184,6 +371,7 @@ public:
                 ++start.curr;
             }
             else {
+                delete[] *start.node;
                 start.set_node(start.node + 1);
                 start.curr = start.first;
             }
@@ -192,11 +380,10 @@ public:
     }
 
     void clear() {
-        for (T** node = start.node; node <= finish.node; ++node) {
-            delete[] *node;
-        }
-        delete[] map;
+        destroy_blocks();
+        map = nullptr;
         _size = 0;
+        start = finish = iterator();
         create_map_and_nodes(0);
     }
 
@@ -206,26 +393,302 @@ public:
 
     T& operator[](size_t index) { return start[index]; }
 
+    const T& operator[](size_t index) const { return start[index]; }
+
     iterator begin() { return start; }
 
     iterator end() { return finish; }
 
+    const_iterator begin() const { return start; }
+
+    const_iterator end() const { return finish; }
+
+    const_iterator cbegin() const { return start; }
+
+    const_iterator cend() const { return finish; }
+
+    //  blocks as contiguous spans, empty blocks are not visited
+    segment_range segments()
+    {
+        return segment_range(segment_iterator(start.node, this), segment_iterator(segments_end(), this));
+    }
+
+    const_segment_range segments() const
+    {
+        return const_segment_range(const_segment_iterator(start.node, this), const_segment_iterator(segments_end(), this));
+    }
+
     void resize(size_t count, const T& value = T())
     {
-        size_t curr_size = _size;
         if (count > _size) {
-            for (int i = 0; i < count - curr_size; ++i) {
-                push_back(value);
+            append_n(count - _size, value);
+        }
+        else {
+            pop_back_n(_size - count);
+        }
+    }
+
+    //  append elements of [first, last) at the back.
+    //  for forward ranges the map and all blocks are reserved once.
+    template<class InputIt, class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    void append(InputIt first, InputIt last)
+    {
+        using category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+            size_t n = std::distance(first, last);
+            ensure_map();
+            size_t new_nodes = reserve_blocks_at_back(n);
+            iterator pos = finish;
+            try {
+                for (size_t left = n; left > 0;) {
+                    size_t chunk = std::min<size_t>(left, pos.last - pos.curr);
+                    copy_to_block(first, chunk, pos.curr);
+                    std::advance(first, chunk);
+                    advance_in_block(pos, chunk);
+                    left -= chunk;
+                }
+            }
+            catch (...) {
+                release_blocks_at_back(new_nodes);
+                throw;
             }
+            finish = pos;
+            _size += n;
         }
         else {
-            for (int i = 0; i < curr_size - count; ++i) {
-                pop_back();
+            for (; first != last; ++first) {
+                push_back(*first);
             }
         }
     }
 
+    //  prepend elements of [first, last) at the front, keeping their order.
+    template<class InputIt, class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    void prepend(InputIt first, InputIt last)
+    {
+        using category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+            size_t n = std::distance(first, last);
+            ensure_map();
+            iterator new_start = reserve_blocks_at_front(n);
+            iterator pos = new_start;
+            try {
+                for (size_t left = n; left > 0;) {
+                    size_t chunk = std::min<size_t>(left, pos.last - pos.curr);
+                    copy_to_block(first, chunk, pos.curr);
+                    std::advance(first, chunk);
+                    advance_in_block(pos, chunk);
+                    left -= chunk;
+                }
+            }
+            catch (...) {
+                release_blocks_at_front(start.node - new_start.node);
+                throw;
+            }
+            start = new_start;
+            _size += n;
+        }
+        else {
+            //  single pass range: stage it reversed, then push_front back in order
+            deque reversed;
+            for (; first != last; ++first) {
+                reversed.push_front(*first);
+            }
+            for (auto it = reversed.begin(); it != reversed.end(); ++it) {
+                push_front(*it);
+            }
+        }
+    }
 
+    //  append count copies of value at the back.
+    void append_n(size_t count, const T& value)
+    {
+        T v_copy = value;   //  value may live inside this deque
+        ensure_map();
+        size_t new_nodes = reserve_blocks_at_back(count);
+        iterator pos = finish;
+        try {
+            for (size_t left = count; left > 0;) {
+                size_t chunk = std::min<size_t>(left, pos.last - pos.curr);
+                std::fill_n(pos.curr, chunk, v_copy);
+                advance_in_block(pos, chunk);
+                left -= chunk;
+            }
+        }
+        catch (...) {
+            release_blocks_at_back(new_nodes);
+            throw;
+        }
+        finish = pos;
+        _size += count;
+    }
+
+    //  prepend count copies of value at the front.
+    void prepend_n(size_t count, const T& value)
+    {
+        T v_copy = value;
+        ensure_map();
+        iterator new_start = reserve_blocks_at_front(count);
+        iterator pos = new_start;
+        try {
+            for (size_t left = count; left > 0;) {
+                size_t chunk = std::min<size_t>(left, pos.last - pos.curr);
+                std::fill_n(pos.curr, chunk, v_copy);
+                advance_in_block(pos, chunk);
+                left -= chunk;
+            }
+        }
+        catch (...) {
+            release_blocks_at_front(start.node - new_start.node);
+            throw;
+        }
+        start = new_start;
+        _size += count;
+    }
+
+    //  overwrite every element with value.
+    void fill(const T& value)
+    {
+        T v_copy = value;
+        for (std::span<T> block : segments()) {
+            std::fill(block.begin(), block.end(), v_copy);
+        }
+    }
+
+    //  insert before pos, shifting whichever side of pos is shorter.
+    iterator insert(iterator pos, const T& value)
+    {
+        T v_copy = value;   //  value may live inside this deque
+        return insert(pos, std::move(v_copy));
+    }
+
+    iterator insert(iterator pos, T&& value)
+    {
+        size_t index = pos - start;
+        open_gap(index, 1);
+        iterator it = start + index;
+        *it = std::move(value);
+        return it;
+    }
+
+    iterator insert(iterator pos, size_t count, const T& value)
+    {
+        T v_copy = value;
+        size_t index = pos - start;
+        open_gap(index, count);
+        iterator it = start + index;
+        for (iterator block = it; count > 0;) {
+            size_t chunk = std::min<size_t>(count, block.last - block.curr);
+            std::fill_n(block.curr, chunk, v_copy);
+            block += chunk;
+            count -= chunk;
+        }
+        return it;
+    }
+
+    template<class InputIt, class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    iterator insert(iterator pos, InputIt first, InputIt last)
+    {
+        using category = typename std::iterator_traits<InputIt>::iterator_category;
+        size_t index = pos - start;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+            size_t count = std::distance(first, last);
+            open_gap(index, count);
+            for (iterator block = start + index; count > 0;) {
+                size_t chunk = std::min<size_t>(count, block.last - block.curr);
+                copy_to_block(first, chunk, block.curr);
+                std::advance(first, chunk);
+                block += chunk;
+                count -= chunk;
+            }
+        }
+        else {
+            deque tmp;
+            tmp.append(first, last);
+            insert(start + index, std::make_move_iterator(tmp.begin()), std::make_move_iterator(tmp.end()));
+        }
+        return start + index;
+    }
+
+    //  erase, shifting whichever side of the erased range is shorter.
+    iterator erase(iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
+
+    iterator erase(iterator first, iterator last)
+    {
+        size_t index = first - start;
+        size_t count = last - first;
+        if (count == 0) {
+            return first;
+        }
+        if (index < (_size - count) / 2) {
+            move_backward_blocks(start, first, last);
+            pop_front_n(count);
+        }
+        else {
+            move_blocks(last, finish, first);
+            pop_back_n(count);
+        }
+        return start + index;
+    }
+
+    //  shrink the map to the blocks in use and release what the
+    //  popped slots of the first and last block still hold.
+    void shrink_to_fit()
+    {
+        if (map == nullptr) return;
+        for (T* p = start.first; p != start.curr; ++p) {
+            *p = T();
+        }
+        for (T* p = finish.curr; p != finish.last; ++p) {
+            *p = T();
+        }
+        size_t num_nodes = finish.node - start.node + 1;
+        size_t new_map_size = num_nodes + 2;
+        if (new_map_size >= map_size) return;
+
+        T** new_map = new T*[new_map_size];
+        T** new_nstart = new_map + 1;
+        std::copy(start.node, finish.node + 1, new_nstart);
+        delete[] map;
+        map = new_map;
+        map_size = new_map_size;
+        //  blocks stay where they are, only the map slots moved.
+        start.set_node(new_nstart);
+        finish.set_node(new_nstart + num_nodes - 1);
+    }
+
+    //  remove min(n, size()) elements from the front, freeing emptied blocks.
+    void pop_front_n(size_t n)
+    {
+        n = std::min(n, _size);
+        if (n == 0) return;
+        size_t offset = (start.curr - start.first) + n;
+        T** new_node = start.node + offset / block_size;
+        for (T** node = start.node; node < new_node; ++node) {
+            delete[] *node;
+        }
+        start.set_node(new_node);
+        start.curr = start.first + offset % block_size;
+        _size -= n;
+    }
+
+    //  remove min(n, size()) elements from the back, freeing emptied blocks.
+    void pop_back_n(size_t n)
+    {
+        n = std::min(n, _size);
+        if (n == 0) return;
+        size_t offset = (finish.node - start.node) * block_size + (finish.curr - finish.first) - n;
+        T** new_node = start.node + offset / block_size;
+        for (T** node = new_node + 1; node <= finish.node; ++node) {
+            delete[] *node;
+        }
+        finish.set_node(new_node);
+        finish.curr = finish.first + offset % block_size;
+        _size -= n;
+    }
 
 private:	//private functions
     void reallocate_map(size_t nodes_to_add, bool add_at_front) {
@@ -275,19 +738,189 @@ private:	//private functions
         }
     }
 
-    void push_back_aux(const T& t) {
-        T t_copy = t;
+    template<class... Args>
+    void push_back_aux(Args&&... args) {
+        //  construct into the last slot first, nothing to undo if it throws.
+        assign_slot(*finish.curr, std::forward<Args>(args)...);
         reserve_map_at_back();
         //  allocate new node buffer.
         *(finish.node + 1) = new T[block_size];
-        //  constructe.
-        *finish.curr = t_copy;
         //  change finish iterator to point to new node.
         finish.set_node(finish.node + 1);
         //  set finish state.
         finish.curr = finish.first;
     }
 
+    //  blocks hold constructed elements, so emplacing is an assignment:
+    //  a single T argument is forwarded as is (copy or move assignment),
+    //  anything else builds a temporary T that is move assigned.
+    template<class... Args>
+    static void assign_slot(T& slot, Args&&... args) {
+        if constexpr (sizeof...(Args) == 1 && (std::is_same_v<std::remove_cvref_t<Args>, T> && ...)) {
+            slot = (std::forward<Args>(args), ...);
+        }
+        else {
+            slot = T(std::forward<Args>(args)...);
+        }
+    }
+
+    //  make sure blocks exist for n more elements after finish
+    //  (finish itself must always stay inside an allocated block),
+    //  returns how many were added. they belong to nobody until finish
+    //  moves over them, so a caller that fails first hands them to
+    //  release_blocks_at_back.
+    size_t reserve_blocks_at_back(size_t n) {
+        size_t new_nodes = (n + (finish.curr - finish.first)) / block_size;
+        if (new_nodes == 0) return 0;
+        reserve_map_at_back(new_nodes);
+        size_t allocated = 0;
+        try {
+            for (; allocated < new_nodes; ++allocated) {
+                *(finish.node + allocated + 1) = new T[block_size];
+            }
+        }
+        catch (...) {
+            release_blocks_at_back(allocated);
+            throw;
+        }
+        return new_nodes;
+    }
+
+    //  allocate blocks for n more elements before start,
+    //  returns iterator to the position of the new first element,
+    //  which sits in the first new block, if any.
+    //  same ownership rule as at the back, see release_blocks_at_front.
+    iterator reserve_blocks_at_front(size_t n) {
+        size_t room = start.curr - start.first;
+        size_t new_nodes = n > room ? (n - room + block_size - 1) / block_size : 0;
+        if (new_nodes > 0) {
+            reserve_map_at_front(new_nodes);
+            size_t allocated = 0;
+            try {
+                for (; allocated < new_nodes; ++allocated) {
+                    *(start.node - allocated - 1) = new T[block_size];
+                }
+            }
+            catch (...) {
+                release_blocks_at_front(allocated);
+                throw;
+            }
+        }
+        iterator pos = start;
+        size_t offset = new_nodes * block_size + room - n;
+        pos.set_node(start.node - new_nodes + offset / block_size);
+        pos.curr = pos.first + offset % block_size;
+        return pos;
+    }
+
+    void release_blocks_at_back(size_t nodes) {
+        for (size_t i = 1; i <= nodes; ++i) {
+            delete[] *(finish.node + i);
+        }
+    }
+
+    void release_blocks_at_front(size_t nodes) {
+        for (size_t i = 1; i <= nodes; ++i) {
+            delete[] *(start.node - i);
+        }
+    }
+
+    //  make room for count elements before index by growing the shorter
+    //  side and shifting its elements over; the gap holds moved-from values.
+    void open_gap(size_t index, size_t count)
+    {
+        if (count == 0) return;
+        ensure_map();
+        if (index < _size / 2) {
+            start = reserve_blocks_at_front(count);
+            _size += count;
+            move_blocks(start + count, start + count + index, start);
+        }
+        else {
+            size_t old_size = _size;
+            reserve_blocks_at_back(count);
+            finish += count;
+            _size += count;
+            move_backward_blocks(start + index, start + old_size, finish);
+        }
+    }
+
+    //  move [first, last) to dest, left to right, one block run at a time.
+    //  dest may overlap the source when it lies before first.
+    //  std::move on the raw runs becomes memmove for trivially copyable T.
+    static iterator move_blocks(iterator first, iterator last, iterator dest)
+    {
+        for (ptrdiff_t n = last - first; n > 0;) {
+            ptrdiff_t chunk = std::min({ n, first.last - first.curr, dest.last - dest.curr });
+            std::move(first.curr, first.curr + chunk, dest.curr);
+            first += chunk;
+            dest += chunk;
+            n -= chunk;
+        }
+        return dest;
+    }
+
+    //  move [first, last) so it ends at d_last, right to left.
+    //  d_last may overlap the source when it lies after last.
+    static iterator move_backward_blocks(iterator first, iterator last, iterator d_last)
+    {
+        for (ptrdiff_t n = last - first; n > 0;) {
+            T* src_end = last.curr == last.first ? *(last.node - 1) + block_size : last.curr;
+            T* dst_end = d_last.curr == d_last.first ? *(d_last.node - 1) + block_size : d_last.curr;
+            ptrdiff_t src_room = last.curr == last.first ? ptrdiff_t(block_size) : last.curr - last.first;
+            ptrdiff_t dst_room = d_last.curr == d_last.first ? ptrdiff_t(block_size) : d_last.curr - d_last.first;
+            ptrdiff_t chunk = std::min({ n, src_room, dst_room });
+            std::move_backward(src_end - chunk, src_end, dst_end);
+            last -= chunk;
+            d_last -= chunk;
+            n -= chunk;
+        }
+        return d_last;
+    }
+
+    //  move pos forward by n elements inside its block,
+    //  stepping into the next block when the current one is filled.
+    static void advance_in_block(iterator& pos, size_t n) {
+        pos.curr += n;
+        if (pos.curr == pos.last) {
+            pos.set_node(pos.node + 1);
+            pos.curr = pos.first;
+        }
+    }
+
+    //  copy n elements into one block, memcpy for trivially copyable T.
+    template<class InputIt>
+    static void copy_to_block(InputIt first, size_t n, T* dest) {
+        using src_type = std::remove_cv_t<std::remove_pointer_t<InputIt>>;
+        if constexpr (std::is_pointer_v<InputIt> && std::is_same_v<src_type, T>
+                      && std::is_trivially_copyable_v<T>) {
+            std::memcpy(dest, first, n * sizeof(T));
+        }
+        else {
+            std::copy_n(first, n, dest);
+        }
+    }
+
+    T** segments_end() const
+    {
+        return empty() ? start.node
+             : (finish.curr == finish.first ? finish.node : finish.node + 1);
+    }
+
+    //  a moved-from deque has no map, growing operations call this first
+    void ensure_map() {
+        if (map == nullptr) {
+            create_map_and_nodes(0);
+        }
+    }
+
+    void destroy_blocks() {
+        if (map == nullptr) return;
+        for (T** node = start.node; node <= finish.node; ++node) {
+            delete[] *node;
+        }
+        delete[] map;
+    }
 
     void create_map_and_nodes(size_t num_elements) {
         size_t num_nodes = num_elements / block_size + 1;
@@ -308,4 +941,59 @@ private:	//private functions
     }
 };
 
+//***********segmented algorithms*******************//
+//  each runs a plain loop over one contiguous block at a time,
+//  so the inner loop has no block boundary checks and can be vectorized.
+
+template<class T, class UnaryFunction>
+UnaryFunction segmented_for_each(deque<T>& d, UnaryFunction f)
+{
+    for (std::span<T> block : d.segments()) {
+        for (T& x : block) {
+            f(x);
+        }
+    }
+    return f;
+}
+
+template<class T, class OutputIt>
+OutputIt segmented_copy(const deque<T>& d, OutputIt out)
+{
+    for (std::span<const T> block : d.segments()) {
+        out = std::copy(block.begin(), block.end(), out);
+    }
+    return out;
+}
+
+template<class T>
+void segmented_fill(deque<T>& d, const T& value)
+{
+    d.fill(value);
+}
+
+template<class T>
+typename deque<T>::iterator segmented_find(deque<T>& d, const T& value)
+{
+    auto segments = d.segments();
+    for (auto it = segments.begin(); it != segments.end(); ++it) {
+        std::span<T> block = *it;
+        auto found = std::find(block.begin(), block.end(), value);
+        if (found != block.end()) {
+            return it.position(&*found);
+        }
+    }
+    return d.end();
+}
+
+template<class T, class U, class BinaryOp = std::plus<>>
+U segmented_accumulate(const deque<T>& d, U init, BinaryOp op = BinaryOp())
+{
+    for (std::span<const T> block : d.segments()) {
+        for (const T& x : block) {
+            init = op(std::move(init), x);
+        }
+    }
+    return init;
+}
+
 #endif // DEQUE_H
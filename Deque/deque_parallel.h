@@ -0,0 +1,142 @@
+#ifndef DEQUE_PARALLEL_H
+#define DEQUE_PARALLEL_H
+
+#include "deque.h"
+
+#include <exception>
+#include <thread>
+#include <vector>
+
+//***********parallel traversal of deque*******************//
+//  work is split along block boundaries: every thread gets a run of
+//  whole blocks, so no two threads ever touch the same block.
+
+namespace deque_parallel_detail
+{
+    //  split blocks into at most `parts` runs of roughly equal element count,
+    //  returns indices of the first block of every run plus the end index.
+    template<class T>
+    std::vector<size_t> partition_blocks(const std::vector<std::span<T>>& blocks, size_t total, size_t parts)
+    {
+        std::vector<size_t> bounds{ 0 };
+        size_t per_part = (total + parts - 1) / parts;
+        size_t taken = 0;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            taken += blocks[i].size();
+            if (taken >= per_part * bounds.size() && i + 1 < blocks.size()) {
+                bounds.push_back(i + 1);
+            }
+        }
+        bounds.push_back(blocks.size());
+        return bounds;
+    }
+
+    template<class T>
+    std::vector<std::span<T>> collect_blocks(deque<T>& d)
+    {
+        std::vector<std::span<T>> blocks;
+        for (std::span<T> block : d.segments()) {
+            blocks.push_back(block);
+        }
+        return blocks;
+    }
+
+    inline size_t thread_count(size_t requested)
+    {
+        if (requested != 0) return requested;
+        size_t hw = std::thread::hardware_concurrency();
+        return hw == 0 ? 1 : hw;
+    }
+
+    //  run task(part) for every part, part 0 on the calling thread,
+    //  rethrows the first exception thrown by any part.
+    //  parts whose thread cannot be started run on the calling thread too.
+    template<class Task>
+    void run_parts(size_t parts, Task& task)
+    {
+        std::vector<std::thread> workers;
+        std::vector<std::exception_ptr> errors(parts);
+        auto run = [&task, &errors](size_t part) {
+            try {
+                task(part);
+            }
+            catch (...) {
+                errors[part] = std::current_exception();
+            }
+        };
+        workers.reserve(parts);
+        size_t spawned = 1;
+        for (; spawned < parts; ++spawned) {
+            try {
+                workers.emplace_back(run, spawned);
+            }
+            catch (...) {
+                break;
+            }
+        }
+        run(0);
+        for (size_t part = spawned; part < parts; ++part) {
+            run(part);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (auto& error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+    }
+}
+
+//  calls f on every element, threads = 0 means hardware concurrency.
+//  f is called concurrently and must be safe to call from several threads.
+template<class T, class UnaryFunction>
+void parallel_for_each(deque<T>& d, UnaryFunction f, size_t threads = 0)
+{
+    auto blocks = deque_parallel_detail::collect_blocks(d);
+    if (blocks.empty()) return;
+
+    auto bounds = deque_parallel_detail::partition_blocks(blocks, d.size(),
+        std::min(deque_parallel_detail::thread_count(threads), blocks.size()));
+    auto task = [&](size_t part) {
+        for (size_t i = bounds[part]; i < bounds[part + 1]; ++i) {
+            for (T& x : blocks[i]) {
+                f(x);
+            }
+        }
+    };
+    deque_parallel_detail::run_parts(bounds.size() - 1, task);
+}
+
+//  reduces all elements with op, threads = 0 means hardware concurrency.
+//  identity seeds every partition, so it must be neutral for op, and op must
+//  be associative and accept both (U, T) and (U, U).
+//  partial results are combined in deque order.
+template<class T, class U, class BinaryOp = std::plus<>>
+U parallel_reduce(deque<T>& d, U identity, BinaryOp op = BinaryOp(), size_t threads = 0)
+{
+    auto blocks = deque_parallel_detail::collect_blocks(d);
+    if (blocks.empty()) return identity;
+
+    auto bounds = deque_parallel_detail::partition_blocks(blocks, d.size(),
+        std::min(deque_parallel_detail::thread_count(threads), blocks.size()));
+    size_t parts = bounds.size() - 1;
+    std::vector<U> partial(parts, identity);
+    auto task = [&](size_t part) {
+        U acc = identity;
+        for (size_t i = bounds[part]; i < bounds[part + 1]; ++i) {
+            for (const T& x : blocks[i]) {
+                acc = op(std::move(acc), x);
+            }
+        }
+        partial[part] = std::move(acc);
+    };
+    deque_parallel_detail::run_parts(parts, task);
+
+    U result = std::move(partial[0]);
+    for (size_t part = 1; part < parts; ++part) {
+        result = op(std::move(result), std::move(partial[part]));
+    }
+    return result;
+}
+
+#endif // DEQUE_PARALLEL_H
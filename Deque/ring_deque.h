@@ -0,0 +1,304 @@
+#ifndef RING_DEQUE_H
+#define RING_DEQUE_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+//  deque over one contiguous power-of-two buffer, element i lives at
+//  buffer[(head + i) & mask]. N > 0 fixes the capacity at compile time
+//  (stored inline), N == 0 takes it at runtime. the buffer is rounded up to
+//  a power of two but holds at most capacity() elements, so an overwriting
+//  window keeps exactly the length it was given.
+//  when full, push either throws std::length_error or, in overwrite mode,
+//  drops the element at the opposite end.
+template<class T, size_t N = 0>
+class ring_deque
+{
+public:
+    template<bool Const>
+    class basic_iterator;
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+private:
+    static constexpr size_t static_capacity = N == 0 ? 0 : std::bit_ceil(N);
+
+    using storage = std::conditional_t<N == 0, T*, std::array<T, static_capacity == 0 ? 1 : static_capacity>>;
+
+    storage buffer{};
+    size_t mask = static_capacity - 1;
+    size_t limit = N;   //  capacity as requested, at most mask + 1
+    size_t head = 0;    //  index of the first element
+    size_t _size = 0;
+    bool overwrite;
+
+public:
+    template<bool Const>
+    class basic_iterator
+    {
+        friend class ring_deque;
+        friend class basic_iterator<!Const>;
+    private:
+        using owner_type = std::conditional_t<Const, const ring_deque, ring_deque>;
+
+        owner_type* owner = nullptr;
+        size_t index = 0;
+
+        basic_iterator(owner_type* owner, size_t index) : owner(owner), index(index) {}
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        basic_iterator() = default;
+
+        //  iterator converts to const_iterator, not the other way round
+        operator basic_iterator<true>() const requires (!Const) { return basic_iterator<true>(owner, index); }
+
+        basic_iterator& operator++() { ++index; return *this; }
+
+        basic_iterator& operator--() { --index; return *this; }
+
+        basic_iterator operator++(int) { auto it = *this; ++index; return it; }
+
+        basic_iterator operator--(int) { auto it = *this; --index; return it; }
+
+        basic_iterator& operator+=(ptrdiff_t n) { index += n; return *this; }
+
+        basic_iterator& operator-=(ptrdiff_t n) { index -= n; return *this; }
+
+        basic_iterator operator+(ptrdiff_t n) const { return basic_iterator(owner, index + n); }
+
+        basic_iterator operator-(ptrdiff_t n) const { return basic_iterator(owner, index - n); }
+
+        reference operator*() const { return (*owner)[index]; }
+
+        pointer operator->() const { return &(*owner)[index]; }
+
+        reference operator[](ptrdiff_t n) const { return (*owner)[index + n]; }
+
+        //  hidden friends, so an iterator on either side converts and
+        //  iterators compare and subtract with const_iterators
+
+        friend ptrdiff_t operator-(const basic_iterator& a, const basic_iterator& b) { return ptrdiff_t(a.index - b.index); }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.index == b.index; }
+
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b) { return a.index != b.index; }
+
+        friend bool operator<(const basic_iterator& a, const basic_iterator& b) { return a.index < b.index; }
+
+        friend bool operator>(const basic_iterator& a, const basic_iterator& b) { return a.index > b.index; }
+
+        friend bool operator<=(const basic_iterator& a, const basic_iterator& b) { return a.index <= b.index; }
+
+        friend bool operator>=(const basic_iterator& a, const basic_iterator& b) { return a.index >= b.index; }
+
+        friend basic_iterator operator+(ptrdiff_t n, const basic_iterator& it) { return it + n; }
+    };
+
+    explicit ring_deque(bool overwrite_oldest = false) requires (N != 0)
+        : overwrite(overwrite_oldest)
+    {
+    }
+
+    explicit ring_deque(size_t capacity, bool overwrite_oldest = false) requires (N == 0)
+        : overwrite(overwrite_oldest)
+    {
+        if (capacity == 0) {
+            throw std::length_error("ring_deque capacity must be positive");
+        }
+        limit = capacity;
+        capacity = std::bit_ceil(capacity);
+        buffer = new T[capacity];
+        mask = capacity - 1;
+    }
+
+    ring_deque(const ring_deque& other)
+        : mask(other.mask), limit(other.limit), head(other.head), _size(other._size), overwrite(other.overwrite)
+    {
+        if constexpr (N == 0) {
+            buffer = new T[mask + 1];
+            std::copy(other.buffer, other.buffer + mask + 1, buffer);
+        }
+        else {
+            buffer = other.buffer;
+        }
+    }
+
+    ring_deque(ring_deque&& other) noexcept
+        : buffer(std::move(other.buffer)), mask(other.mask), limit(other.limit), head(other.head),
+          _size(other._size), overwrite(other.overwrite)
+    {
+        if constexpr (N == 0) {
+            other.buffer = nullptr;
+            other.mask = size_t(-1);    //  buffer of size 0
+            other.limit = 0;
+            other.head = 0;
+            other._size = 0;
+        }
+    }
+
+    ring_deque& operator=(ring_deque other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~ring_deque()
+    {
+        if constexpr (N == 0) {
+            delete[] buffer;
+        }
+    }
+
+    void swap(ring_deque& other) noexcept
+    {
+        std::swap(buffer, other.buffer);
+        std::swap(mask, other.mask);
+        std::swap(limit, other.limit);
+        std::swap(head, other.head);
+        std::swap(_size, other._size);
+        std::swap(overwrite, other.overwrite);
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    void push_front(const T& value) { emplace_front(value); }
+
+    void push_front(T&& value) { emplace_front(std::move(value)); }
+
+    template<class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (full()) {
+            make_room();
+            head = (head + 1) & mask;   //  drop the oldest (front) element
+            --_size;
+        }
+        T& slot = data()[(head + _size) & mask];
+        slot = T(std::forward<Args>(args)...);
+        ++_size;
+        return slot;
+    }
+
+    template<class... Args>
+    T& emplace_front(Args&&... args)
+    {
+        if (full()) {
+            make_room();
+            --_size;                    //  drop the back element
+        }
+        head = (head - 1) & mask;
+        T& slot = data()[head];
+        slot = T(std::forward<Args>(args)...);
+        ++_size;
+        return slot;
+    }
+
+    void pop_back()
+    {
+        if (!empty()) {
+            --_size;
+        }
+    }
+
+    void pop_front()
+    {
+        if (!empty()) {
+            head = (head + 1) & mask;
+            --_size;
+        }
+    }
+
+    T& operator[](size_t index) { return data()[(head + index) & mask]; }
+
+    const T& operator[](size_t index) const { return data()[(head + index) & mask]; }
+
+    T& at(size_t index)
+    {
+        if (index >= _size) {
+            throw std::out_of_range("invalid ring_deque subscript");
+        }
+        return (*this)[index];
+    }
+
+    const T& at(size_t index) const
+    {
+        if (index >= _size) {
+            throw std::out_of_range("invalid ring_deque subscript");
+        }
+        return (*this)[index];
+    }
+
+    T& front() { return data()[head]; }
+
+    const T& front() const { return data()[head]; }
+
+    T& back() { return data()[(head + _size - 1) & mask]; }
+
+    const T& back() const { return data()[(head + _size - 1) & mask]; }
+
+    size_t size() const { return _size; }
+
+    size_t capacity() const { return limit; }
+
+    bool empty() const { return _size == 0; }
+
+    bool full() const { return _size == capacity(); }
+
+    bool overwrites() const { return overwrite; }
+
+    void set_overwrite(bool overwrite_oldest) { overwrite = overwrite_oldest; }
+
+    void clear()
+    {
+        head = 0;
+        _size = 0;
+    }
+
+    iterator begin() { return iterator(this, 0); }
+
+    iterator end() { return iterator(this, _size); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+
+    const_iterator end() const { return const_iterator(this, _size); }
+
+    const_iterator cbegin() const { return begin(); }
+
+    const_iterator cend() const { return end(); }
+
+private:
+    T* data()
+    {
+        if constexpr (N == 0) return buffer;
+        else return buffer.data();
+    }
+
+    const T* data() const
+    {
+        if constexpr (N == 0) return buffer;
+        else return buffer.data();
+    }
+
+    void make_room()
+    {
+        if (!overwrite || capacity() == 0) {
+            throw std::length_error("ring_deque is full");
+        }
+    }
+};
+
+#endif // RING_DEQUE_H
@@ -0,0 +1,196 @@
+#ifndef SPILL_DEQUE_H
+#define SPILL_DEQUE_H
+
+#include "deque.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+//  FIFO deque (push_back / pop_front) that keeps at most a memory budget
+//  of blocks in RAM. when the budget is exceeded, freshly filled blocks in
+//  the middle of the queue are written to an unlinked spill file and read
+//  back with pread() once the front reaches them. the front and back blocks
+//  always stay in memory, at most one block over budget (the reloaded front).
+//  blocks are written as raw bytes, so T must be trivially copyable.
+template<class T>
+class spill_deque
+{
+    static_assert(std::is_trivially_copyable_v<T>, "spill_deque writes elements to disk as raw bytes");
+
+    static constexpr size_t block_bytes = 64 * 1024;
+    static constexpr size_t block_size = sizeof(T) < block_bytes ? block_bytes / sizeof(T) : 1;
+    static constexpr size_t bytes_per_block = block_size * sizeof(T);
+
+    struct block
+    {
+        T* data = nullptr;  //  nullptr while the block is on disk
+        off_t offset = -1;  //  position in the spill file
+    };
+
+    deque<block> sealed;    //  full blocks, front of the queue first
+    T* tail = nullptr;      //  block being filled by push_back
+    size_t tail_count = 0;
+    size_t head = 0;        //  index of the front element in the front block
+    size_t _size = 0;
+
+    size_t resident = 1;    //  blocks in memory, counting the tail
+    size_t max_resident;
+    size_t spilled = 0;
+
+    std::filesystem::path spill_dir;
+    int fd = -1;
+    off_t file_end = 0;
+    std::vector<off_t> free_offsets;
+
+public:
+    explicit spill_deque(size_t memory_budget,
+                         std::filesystem::path spill_dir = std::filesystem::temp_directory_path())
+        : max_resident(std::max<size_t>(2, memory_budget / bytes_per_block)),
+          spill_dir(std::move(spill_dir))
+    {
+        tail = new T[block_size];
+    }
+
+    spill_deque(const spill_deque&) = delete;
+
+    spill_deque& operator=(const spill_deque&) = delete;
+
+    ~spill_deque()
+    {
+        for (auto it = sealed.begin(); it != sealed.end(); ++it) {
+            delete[] (*it).data;
+        }
+        delete[] tail;
+        if (fd != -1) {
+            ::close(fd);
+        }
+    }
+
+    void push_back(const T& value)
+    {
+        if (tail_count == block_size) {
+            seal_tail();
+        }
+        tail[tail_count++] = value;
+        ++_size;
+    }
+
+    void pop_front()
+    {
+        if (empty()) return;
+        ++head;
+        --_size;
+        if (_size == 0) {
+            //  everything consumed, the front was the tail block
+            head = 0;
+            tail_count = 0;
+        }
+        else if (!sealed.empty() && head == block_size) {
+            delete[] (*sealed.begin()).data;
+            sealed.pop_front();
+            --resident;
+            head = 0;
+            if (!sealed.empty()) {
+                load(*sealed.begin());
+            }
+        }
+    }
+
+    T& front() { return sealed.empty() ? tail[head] : (*sealed.begin()).data[head]; }
+
+    T& back() { return tail[tail_count - 1]; }
+
+    size_t size() const { return _size; }
+
+    bool empty() const { return _size == 0; }
+
+    //  number of blocks currently held only in the spill file
+    size_t spilled_blocks() const { return spilled; }
+
+    size_t resident_blocks() const { return resident; }
+
+private:
+    void seal_tail()
+    {
+        block b;
+        b.data = tail;
+        //  the block becoming the front must stay readable in memory
+        if (!sealed.empty() && resident >= max_resident) {
+            spill(b);
+        }
+        sealed.push_back(b);
+        tail = new T[block_size];
+        tail_count = 0;
+        ++resident;
+    }
+
+    void spill(block& b)
+    {
+        open_spill_file();
+        if (free_offsets.empty()) {
+            b.offset = file_end;
+            file_end += bytes_per_block;
+        }
+        else {
+            b.offset = free_offsets.back();
+            free_offsets.pop_back();
+        }
+        const char* src = reinterpret_cast<const char*>(b.data);
+        for (size_t done = 0; done < bytes_per_block;) {
+            ssize_t n = ::pwrite(fd, src + done, bytes_per_block - done, b.offset + done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                free_offsets.push_back(b.offset);
+                throw std::system_error(errno, std::generic_category(), "spill_deque: write to spill file failed");
+            }
+            done += n;
+        }
+        delete[] b.data;
+        b.data = nullptr;
+        --resident;
+        ++spilled;
+    }
+
+    void load(block& b)
+    {
+        if (b.data != nullptr) return;
+        T* data = new T[block_size];
+        char* dst = reinterpret_cast<char*>(data);
+        for (size_t done = 0; done < bytes_per_block;) {
+            ssize_t n = ::pread(fd, dst + done, bytes_per_block - done, b.offset + done);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) continue;
+                delete[] data;
+                throw std::system_error(n < 0 ? errno : EIO, std::generic_category(), "spill_deque: read from spill file failed");
+            }
+            done += n;
+        }
+        b.data = data;
+        free_offsets.push_back(b.offset);
+        b.offset = -1;
+        ++resident;
+        --spilled;
+    }
+
+    void open_spill_file()
+    {
+        if (fd != -1) return;
+        std::string name = (spill_dir / "spill_deque.XXXXXX").string();
+        fd = ::mkstemp(name.data());
+        if (fd == -1) {
+            throw std::system_error(errno, std::generic_category(), "spill_deque: cannot create spill file");
+        }
+        //  the file lives only as long as the descriptor
+        ::unlink(name.c_str());
+    }
+};
+
+#endif // SPILL_DEQUE_H
@@ -0,0 +1,64 @@
+#pragma once
+
+
+#include "map.h"
+#include "BTree.h"
+
+//Map interface over the B+tree engine, for large ordered indexes
+//where cache misses per lookup and range scans dominate.
+template<class KeyT, class ValueT, class Compare = std::less<KeyT>,
+		 class Allocator = std::allocator<std::pair<const KeyT, ValueT>>>
+class BTreeMap : public BTree<MapTraits<KeyT, ValueT, Compare, Allocator>>
+{
+	using Tree = BTree<MapTraits<KeyT, ValueT, Compare, Allocator>>;
+public:
+	using MappedType	     = ValueT;
+	using iterator			 = typename Tree::Iterator;
+	using ValueType			 = typename MapTraits<KeyT, ValueT, Compare, Allocator>::value;
+	using KeyType		     = typename MapTraits<KeyT, ValueT, Compare, Allocator>::key;
+
+
+	BTreeMap() : Tree() {
+
+	}
+
+	explicit BTreeMap(const Allocator& alloc) : Tree(alloc) {
+
+	}
+
+	BTreeMap(const BTreeMap& other) : Tree(other.get_allocator()) {
+		this->cloneFrom(other);
+	}
+
+	BTreeMap(std::initializer_list<ValueType> init) : Tree() {
+		for (const auto& it : init) {
+			insert(it);
+		}
+	}
+
+	~BTreeMap() {
+
+	}
+
+	std::pair<iterator, bool> insert(const ValueType& value)
+	{
+		return Tree::insert(value);
+	}
+
+	//value-initializes the mapped value only when key is new
+	MappedType& operator[](const KeyType& key)
+	{
+		return Tree::insertUnique(key, std::piecewise_construct,
+			std::forward_as_tuple(key), std::forward_as_tuple()).first->second;
+	}
+
+	MappedType& at(const KeyType& key)
+	{
+		ValueType* value = Tree::search(key);
+		if (value != nullptr) {
+			return value->second;
+		}
+		else throw std::out_of_range("invalid map<K, T> key");
+	}
+
+};
@@ -0,0 +1,402 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//ordered map for many readers and a few writers: a lazy skip list
+//(Herlihy, Lev, Luchangco, Shavit). lookups and scans take no locks and
+//never wait; insert and erase lock only the predecessors of the node
+//they change. unlinked nodes are freed by epoch-based reclamation, once
+//no reader that could still see them is inside an operation.
+//values are copied out, never handed out by reference, and are not
+//modified in place: to change one, erase and insert it again.
+template<class KeyT, class ValueT, class Compare = std::less<KeyT>>
+class concurrent_map
+{
+public:
+	using KeyType    = KeyT;
+	using MappedType = ValueT;
+	using ValueType  = std::pair<const KeyT, ValueT>;
+
+private:
+	static constexpr int max_level = 32;
+	static constexpr size_t reclaim_threshold = 64;
+
+	struct Node
+	{
+		explicit Node(int top_level) : top_level(top_level), next(new std::atomic<Node*>[top_level + 1])
+		{
+			for (int level = 0; level <= top_level; ++level) {
+				next[level].store(nullptr, std::memory_order_relaxed);
+			}
+		}
+
+		~Node() { delete[] next; }
+
+		union { ValueType value; };		//not constructed in the head
+		const int top_level;
+		std::atomic<Node*>* next;
+		std::atomic<bool> marked{ false };		//logically removed
+		std::atomic<bool> fully_linked{ false };
+		std::mutex lock;
+	};
+
+	//***********epoch-based reclamation*******************//
+
+	//one per thread inside an operation, records are reused and freed with the map
+	struct EpochRecord
+	{
+		std::atomic<uint64_t> epoch{ 0 };
+		std::atomic<bool> in_use{ false };
+		EpochRecord* next = nullptr;
+	};
+
+	class Guard
+	{
+	private:
+		EpochRecord* record;
+	public:
+		explicit Guard(const concurrent_map& map) : record(map.enterEpoch()) { }
+
+		Guard(const Guard&) = delete;
+
+		Guard& operator=(const Guard&) = delete;
+
+		~Guard() { record->in_use.store(false, std::memory_order_release); }
+	};
+
+	Node* head;
+	Compare comp;
+	std::atomic<size_t> _size{ 0 };
+
+	mutable std::atomic<EpochRecord*> records{ nullptr };
+	std::atomic<uint64_t> global_epoch{ 0 };
+	std::mutex retire_lock;
+	std::vector<std::pair<uint64_t, Node*>> retired;	//epoch of unlinking, node
+
+public:
+	concurrent_map() : head(new Node(max_level - 1)) { }
+
+	explicit concurrent_map(const Compare& compare) : head(new Node(max_level - 1)), comp(compare) { }
+
+	concurrent_map(const concurrent_map&) = delete;
+
+	concurrent_map& operator=(const concurrent_map&) = delete;
+
+	//no other thread may use the map any more
+	~concurrent_map()
+	{
+		Node* node = head->next[0].load(std::memory_order_relaxed);
+		while (node != nullptr) {
+			Node* next = node->next[0].load(std::memory_order_relaxed);
+			destroyNode(node);
+			node = next;
+		}
+		delete head;
+		for (auto& entry : retired) {
+			destroyNode(entry.second);
+		}
+		for (EpochRecord* record = records.load(); record != nullptr;) {
+			EpochRecord* next = record->next;
+			delete record;
+			record = next;
+		}
+	}
+
+	size_t size() const { return _size.load(std::memory_order_relaxed); }
+
+	bool empty() const { return size() == 0; }
+
+	bool contains(const KeyType& key) const
+	{
+		Guard guard(*this);
+		return findLive(key) != nullptr;
+	}
+
+	size_t count(const KeyType& key) const { return contains(key) ? 1 : 0; }
+
+	//copy of the mapped value, empty if key is absent
+	std::optional<MappedType> find(const KeyType& key) const
+	{
+		Guard guard(*this);
+		Node* node = findLive(key);
+		if (node == nullptr) return std::nullopt;
+		return node->value.second;
+	}
+
+	//calls f(const ValueType&) on the elements in key order. a scan running
+	//alongside writers sees every element present for its whole duration and
+	//may or may not see elements inserted or erased meanwhile
+	template<class Function>
+	void for_each(Function f) const
+	{
+		Guard guard(*this);
+		visit(head->next[0].load(std::memory_order_acquire), nullptr, f);
+	}
+
+	//same for keys in [lo, hi)
+	template<class Function>
+	void for_each_range(const KeyType& lo, const KeyType& hi, Function f) const
+	{
+		Guard guard(*this);
+		Node* preds[max_level];
+		Node* succs[max_level];
+		findPosition(lo, preds, succs);
+		visit(succs[0], &hi, f);
+	}
+
+	//false if the key is already present
+	bool insert(const ValueType& value)
+	{
+		Guard guard(*this);
+		int top_level = randomLevel();
+		Node* preds[max_level];
+		Node* succs[max_level];
+		for (;;) {
+			int found_level = findPosition(value.first, preds, succs);
+			if (found_level != -1) {
+				Node* found = succs[found_level];
+				if (!found->marked.load(std::memory_order_acquire)) {
+					//an insert in progress, wait until it is visible to everyone
+					while (!found->fully_linked.load(std::memory_order_acquire)) {
+						std::this_thread::yield();
+					}
+					return false;
+				}
+				continue;		//being removed, retry once it is unlinked
+			}
+
+			int locked = -1;
+			bool valid = true;
+			for (int level = 0; valid && level <= top_level; ++level) {
+				Node* pred = preds[level];
+				Node* succ = succs[level];
+				if (level == 0 || pred != preds[level - 1]) pred->lock.lock();
+				locked = level;
+				valid = !pred->marked.load(std::memory_order_acquire)
+					&& (succ == nullptr || !succ->marked.load(std::memory_order_acquire))
+					&& pred->next[level].load(std::memory_order_acquire) == succ;
+			}
+			if (!valid) {
+				unlockPreds(preds, locked);
+				continue;
+			}
+
+			Node* node;
+			try {
+				node = createNode(top_level, value);
+			}
+			catch (...) {
+				unlockPreds(preds, locked);
+				throw;
+			}
+			for (int level = 0; level <= top_level; ++level) {
+				node->next[level].store(succs[level], std::memory_order_relaxed);
+			}
+			for (int level = 0; level <= top_level; ++level) {
+				preds[level]->next[level].store(node, std::memory_order_release);
+			}
+			node->fully_linked.store(true, std::memory_order_release);
+			_size.fetch_add(1, std::memory_order_relaxed);
+			unlockPreds(preds, locked);
+			return true;
+		}
+	}
+
+	//false if the key is absent
+	bool erase(const KeyType& key)
+	{
+		Guard guard(*this);
+		Node* preds[max_level];
+		Node* succs[max_level];
+		Node* victim = nullptr;
+		bool is_marked = false;
+		int top_level = -1;
+		for (;;) {
+			int found_level = findPosition(key, preds, succs);
+			if (!is_marked) {
+				if (found_level == -1) return false;
+				victim = succs[found_level];
+				//only a node that is fully inserted and found at its own top level
+				//is safe to remove, anything else is an insert or erase in progress
+				if (!victim->fully_linked.load(std::memory_order_acquire) || victim->top_level != found_level
+					|| victim->marked.load(std::memory_order_acquire)) {
+					return false;
+				}
+				top_level = victim->top_level;
+				victim->lock.lock();
+				if (victim->marked.load(std::memory_order_relaxed)) {
+					victim->lock.unlock();
+					return false;
+				}
+				victim->marked.store(true, std::memory_order_release);
+				is_marked = true;
+			}
+
+			int locked = -1;
+			bool valid = true;
+			for (int level = 0; valid && level <= top_level; ++level) {
+				Node* pred = preds[level];
+				if (level == 0 || pred != preds[level - 1]) pred->lock.lock();
+				locked = level;
+				valid = !pred->marked.load(std::memory_order_acquire)
+					&& pred->next[level].load(std::memory_order_acquire) == victim;
+			}
+			if (!valid) {
+				unlockPreds(preds, locked);
+				continue;
+			}
+
+			for (int level = top_level; level >= 0; --level) {
+				preds[level]->next[level].store(victim->next[level].load(std::memory_order_relaxed), std::memory_order_release);
+			}
+			victim->lock.unlock();
+			unlockPreds(preds, locked);
+			_size.fetch_sub(1, std::memory_order_relaxed);
+			retire(victim);
+			return true;
+		}
+	}
+
+private:
+	//fills the predecessors and successors of key on every level,
+	//returns the highest level where key was found or -1
+	int findPosition(const KeyType& key, Node** preds, Node** succs) const
+	{
+		int found_level = -1;
+		Node* pred = head;
+		for (int level = max_level - 1; level >= 0; --level) {
+			Node* curr = pred->next[level].load(std::memory_order_acquire);
+			while (curr != nullptr && comp(curr->value.first, key)) {
+				pred = curr;
+				curr = pred->next[level].load(std::memory_order_acquire);
+			}
+			if (found_level == -1 && curr != nullptr && !comp(key, curr->value.first)) {
+				found_level = level;
+			}
+			preds[level] = pred;
+			succs[level] = curr;
+		}
+		return found_level;
+	}
+
+	Node* findLive(const KeyType& key) const
+	{
+		Node* preds[max_level];
+		Node* succs[max_level];
+		int found_level = findPosition(key, preds, succs);
+		if (found_level == -1) return nullptr;
+		Node* node = succs[found_level];
+		if (!node->fully_linked.load(std::memory_order_acquire) || node->marked.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+		return node;
+	}
+
+	template<class Function>
+	void visit(Node* node, const KeyType* hi, Function& f) const
+	{
+		for (; node != nullptr; node = node->next[0].load(std::memory_order_acquire)) {
+			if (hi && !comp(node->value.first, *hi)) break;
+			if (node->fully_linked.load(std::memory_order_acquire) && !node->marked.load(std::memory_order_acquire)) {
+				f(static_cast<const ValueType&>(node->value));
+			}
+		}
+	}
+
+	//locks are taken once per distinct predecessor, which are adjacent in preds
+	static void unlockPreds(Node** preds, int locked)
+	{
+		for (int level = 0; level <= locked; ++level) {
+			if (level == 0 || preds[level] != preds[level - 1]) preds[level]->lock.unlock();
+		}
+	}
+
+	//geometric with p = 1/2
+	static int randomLevel()
+	{
+		thread_local std::minstd_rand engine(static_cast<unsigned>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+		uint32_t bits = static_cast<uint32_t>(engine()) | (1u << (max_level - 1));
+		return std::min(std::countr_zero(bits), max_level - 1);
+	}
+
+	static Node* createNode(int top_level, const ValueType& value)
+	{
+		Node* node = new Node(top_level);
+		try {
+			::new (static_cast<void*>(&node->value)) ValueType(value);
+		}
+		catch (...) {
+			delete node;
+			throw;
+		}
+		return node;
+	}
+
+	static void destroyNode(Node* node)
+	{
+		node->value.~ValueType();
+		delete node;
+	}
+
+	//claims a free record, or adds one, and publishes the current epoch in it
+	EpochRecord* enterEpoch() const
+	{
+		EpochRecord* record = records.load(std::memory_order_acquire);
+		for (; record != nullptr; record = record->next) {
+			if (!record->in_use.load(std::memory_order_relaxed)
+				&& !record->in_use.exchange(true, std::memory_order_acquire)) {
+				break;
+			}
+		}
+		if (record == nullptr) {
+			record = new EpochRecord;
+			record->in_use.store(true, std::memory_order_relaxed);
+			EpochRecord* first = records.load(std::memory_order_relaxed);
+			do {
+				record->next = first;
+			} while (!records.compare_exchange_weak(first, record, std::memory_order_release, std::memory_order_relaxed));
+		}
+		record->epoch.store(global_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		return record;
+	}
+
+	//a node unlinked in epoch e can only be seen by operations that entered
+	//in epoch e or earlier, so it is freed once the epoch reaches e + 2
+	void retire(Node* node)
+	{
+		std::lock_guard<std::mutex> hold(retire_lock);
+		retired.emplace_back(global_epoch.load(std::memory_order_seq_cst), node);
+		if (retired.size() < reclaim_threshold) return;
+
+		uint64_t epoch = global_epoch.load(std::memory_order_seq_cst);
+		bool all_current = true;
+		for (EpochRecord* record = records.load(std::memory_order_acquire); record != nullptr; record = record->next) {
+			if (record->in_use.load(std::memory_order_seq_cst) && record->epoch.load(std::memory_order_seq_cst) != epoch) {
+				all_current = false;
+				break;
+			}
+		}
+		if (all_current) {
+			global_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+		}
+
+		uint64_t now = global_epoch.load(std::memory_order_seq_cst);
+		auto freed = std::partition(retired.begin(), retired.end(),
+			[now](const std::pair<uint64_t, Node*>& entry) { return entry.first + 2 > now; });
+		for (auto it = freed; it != retired.end(); ++it) {
+			destroyNode(it->second);
+		}
+		retired.erase(freed, retired.end());
+	}
+};
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "../Set/flat_set.h"
+
+#include <stdexcept>
+
+//sorted map over two parallel arrays, keys and values, so a lookup only
+//touches the keys. same trade-offs as flat_set: fast search and iteration,
+//linear single inserts and erases, bulk insert(first, last) merges once.
+//iterators dereference to a pair of references.
+template<class Key, class T, class Compare = std::less<Key>>
+class flat_map
+{
+	vector<Key> key_array;
+	vector<T> value_array;
+	Compare comp;
+
+public:
+	using ValueType = std::pair<Key, T>;
+	using reference = std::pair<const Key&, T&>;
+
+	class Iterator
+	{
+		friend class flat_map;
+	private:
+		flat_map* owner = nullptr;
+		size_t index = 0;
+
+		Iterator(flat_map* owner, size_t index) : owner(owner), index(index) { }
+
+		struct Arrow
+		{
+			reference ref;
+			reference* operator->() { return &ref; }
+		};
+
+	public:
+		Iterator() { }
+
+		Iterator& operator++() { ++index; return *this; }
+
+		Iterator& operator--() { --index; return *this; }
+
+		Iterator operator++(int) { auto it = *this; ++index; return it; }
+
+		Iterator operator--(int) { auto it = *this; --index; return it; }
+
+		reference operator*() const { return reference(owner->key_array[index], owner->value_array[index]); }
+
+		Arrow operator->() const { return Arrow{ **this }; }
+
+		bool operator==(const Iterator& other) const { return index == other.index; }
+
+		bool operator!=(const Iterator& other) const { return index != other.index; }
+	};
+
+	using iterator = Iterator;
+
+	flat_map() { }
+
+	explicit flat_map(const Compare& compare) : comp(compare) { }
+
+	template<class InputIt>
+	flat_map(InputIt first, InputIt last)
+	{
+		insert(first, last);
+	}
+
+	flat_map(std::initializer_list<ValueType> init)
+	{
+		insert(init.begin(), init.end());
+	}
+
+	iterator begin() { return iterator(this, 0); }
+
+	iterator end() { return iterator(this, size()); }
+
+	size_t size() const { return key_array.size(); }
+
+	bool empty() const { return key_array.empty(); }
+
+	void clear()
+	{
+		key_array.clear();
+		value_array.clear();
+	}
+
+	void reserve(size_t count)
+	{
+		key_array.reserve(count);
+		value_array.reserve(count);
+	}
+
+	const vector<Key>& keys() const { return key_array; }
+
+	const vector<T>& values() const { return value_array; }
+
+	iterator lower_bound(const Key& key)
+	{
+		return iterator(this, lowerIndex(key));
+	}
+
+	iterator upper_bound(const Key& key)
+	{
+		return iterator(this, flat_detail::partition_point(keyData(), size(),
+			[&](const Key& k) { return !comp(key, k); }));
+	}
+
+	iterator find(const Key& key)
+	{
+		size_t index = findIndex(key);
+		return iterator(this, index);
+	}
+
+	bool contains(const Key& key) const { return findIndex(key) != size(); }
+
+	size_t count(const Key& key) const { return contains(key) ? 1 : 0; }
+
+	T& at(const Key& key)
+	{
+		size_t index = findIndex(key);
+		if (index == size()) {
+			throw std::out_of_range("invalid flat_map<K, T> key");
+		}
+		return value_array[index];
+	}
+
+	T& operator[](const Key& key)
+	{
+		return (*insert(ValueType(key, T())).first).second;
+	}
+
+	std::pair<iterator, bool> insert(const ValueType& value)
+	{
+		size_t index = lowerIndex(value.first);
+		if (index < size() && !comp(value.first, key_array[index])) {
+			return std::make_pair(iterator(this, index), false);
+		}
+		flat_detail::insert_at(key_array, index, value.first);
+		try {
+			flat_detail::insert_at(value_array, index, value.second);
+		}
+		catch (...) {
+			flat_detail::erase_at(key_array, index);
+			throw;
+		}
+		return std::make_pair(iterator(this, index), true);
+	}
+
+	//O(n + k log k) for k new elements; keys already present keep their values
+	template<class InputIt>
+	void insert(InputIt first, InputIt last)
+	{
+		vector<ValueType> incoming;
+		for (; first != last; ++first) {
+			incoming.push_back(ValueType((*first).first, (*first).second));
+		}
+		if (incoming.empty()) return;
+		auto less = [&](const ValueType& a, const ValueType& b) { return comp(a.first, b.first); };
+		size_t count = flat_detail::sort_unique(&incoming[0], &incoming[0] + incoming.size(), less) - &incoming[0];
+
+		size_t n = size();
+		if (n == 0 || comp(key_array[n - 1], incoming[0].first)) {		//pure append
+			reserve(n + count);
+			for (size_t j = 0; j < count; ++j) {
+				key_array.push_back(std::move(incoming[j].first));
+				value_array.push_back(std::move(incoming[j].second));
+			}
+			return;
+		}
+
+		vector<Key> keys;
+		vector<T> values;
+		keys.reserve(n + count);
+		values.reserve(n + count);
+		size_t i = 0, j = 0;
+		while (i < n || j < count) {
+			bool take_new = i == n || (j < count && comp(incoming[j].first, key_array[i]));
+			if (take_new) {
+				keys.push_back(std::move(incoming[j].first));
+				values.push_back(std::move(incoming[j].second));
+				++j;
+			}
+			else {
+				if (j < count && !comp(key_array[i], incoming[j].first)) ++j;		//already present
+				keys.push_back(std::move(key_array[i]));
+				values.push_back(std::move(value_array[i]));
+				++i;
+			}
+		}
+		key_array.swap(keys);
+		value_array.swap(values);
+	}
+
+	size_t erase(const Key& key)
+	{
+		size_t index = findIndex(key);
+		if (index == size()) return 0;
+		erase(iterator(this, index));
+		return 1;
+	}
+
+	iterator erase(iterator pos)
+	{
+		flat_detail::erase_at(key_array, pos.index);
+		flat_detail::erase_at(value_array, pos.index);
+		return pos;
+	}
+
+private:
+	const Key* keyData() const { return key_array.empty() ? nullptr : &key_array[0]; }
+
+	size_t lowerIndex(const Key& key) const
+	{
+		return flat_detail::partition_point(keyData(), size(),
+			[&](const Key& k) { return comp(k, key); });
+	}
+
+	//index of key, size() if absent
+	size_t findIndex(const Key& key) const
+	{
+		size_t index = lowerIndex(key);
+		return (index < size() && !comp(key, key_array[index])) ? index : size();
+	}
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+
+#include "RedBlackTree.h"
+
+#include <stdexcept>
+
+//keys are closed intervals [lo, hi], ordered by lo then hi;
+//every node summarises the largest hi in its subtree
+template<class Point, class ValueType, class Compare>
+class IntervalTraits
+{
+public:
+	using key = std::pair<Point, Point>;
+	using value = std::pair<const key, ValueType>;
+	using allocator_type = std::allocator<value>;
+	using summary_type = Point;
+
+	struct key_compare
+	{
+		Compare comp;
+
+		bool operator()(const key& a, const key& b) const
+		{
+			if (comp(a.first, b.first)) return true;
+			if (comp(b.first, a.first)) return false;
+			return comp(a.second, b.second);
+		}
+	};
+
+	static const key& get_key(const value& v) { return v.first; }
+
+	static Point summarize(const value& v, const Point* left, const Point* right)
+	{
+		Compare comp;
+		const Point* result = &v.first.second;
+		if (left && comp(*result, *left)) result = left;
+		if (right && comp(*result, *right)) result = right;
+		return *result;
+	}
+};
+
+
+template<class Point, class ValueT, class Compare = std::less<Point>>
+class IntervalMap : public RBTree<IntervalTraits<Point, ValueT, Compare>>
+{
+	using Tree = RBTree<IntervalTraits<Point, ValueT, Compare>>;
+	using Node = typename Tree::Node;
+public:
+	using MappedType = ValueT;
+	using iterator	 = typename Tree::Iterator;
+	using Interval	 = typename IntervalTraits<Point, ValueT, Compare>::key;
+	using ValueType	 = typename IntervalTraits<Point, ValueT, Compare>::value;
+
+
+	IntervalMap() { }
+
+	~IntervalMap() { }
+
+	std::pair<iterator, bool> insert(const Point& lo, const Point& hi, const MappedType& value)
+	{
+		if (point_comp(hi, lo)) {
+			throw std::invalid_argument("interval end precedes its start");
+		}
+		return Tree::insert(ValueType(Interval(lo, hi), value));
+	}
+
+	bool erase(const Point& lo, const Point& hi)
+	{
+		return Tree::erase(Interval(lo, hi));
+	}
+
+	//calls f(ValueType&) for every interval intersecting [lo, hi], in key order.
+	//subtrees whose largest end is below lo or whose starts are all above hi
+	//are skipped, so the cost is O(log n) per reported interval at worst
+	template<class Function>
+	void for_each_overlap(const Point& lo, const Point& hi, Function f)
+	{
+		collect(this->root, lo, hi, f);
+	}
+
+	//calls f for every interval containing point
+	template<class Function>
+	void for_each_containing(const Point& point, Function f)
+	{
+		collect(this->root, point, point, f);
+	}
+
+	//some interval intersecting [lo, hi], end() if there is none, O(log n)
+	iterator find_overlap(const Point& lo, const Point& hi)
+	{
+		Node* node = this->root;
+		while (node != nullptr) {
+			if (intersects(node, lo, hi)) break;
+			//the left subtree is the only hope if it reaches lo: when it does
+			//not overlap there, its intervals ending at or after lo all start
+			//after hi, and so do all of the right subtree
+			if (node->left && !point_comp(node->left->summary, lo)) {
+				node = node->left;
+			}
+			else {
+				node = node->right;
+			}
+		}
+		return iterator(node, this);
+	}
+
+private:
+	Compare point_comp;
+
+	bool intersects(const Node* node, const Point& lo, const Point& hi) const
+	{
+		const Interval& interval = node->value.first;
+		return !point_comp(hi, interval.first) && !point_comp(interval.second, lo);
+	}
+
+	template<class Function>
+	void collect(Node* node, const Point& lo, const Point& hi, Function& f)
+	{
+		if (node == nullptr || point_comp(node->summary, lo)) return;
+		collect(node->left, lo, hi, f);
+		if (point_comp(hi, node->value.first.first)) return;	//this node and the right subtree start after hi
+		if (!point_comp(node->value.first.second, lo)) f(node->value);
+		collect(node->right, lo, hi, f);
+	}
+};
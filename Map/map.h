@@ -3,20 +3,27 @@
 
 #include "RedBlackTree.h" 
 
-template<class KeyType, class ValueType, class Compare>
+#include <tuple>
+
+template<class KeyType, class ValueType, class Compare,
+		 class Allocator = std::allocator<std::pair<const KeyType, ValueType>>>
 class MapTraits 
 {
 public:
 	using key = KeyType;
 	using value = std::pair<const KeyType, ValueType>;
 	using key_compare = Compare;
+	using allocator_type = Allocator;
+
+	static const key& get_key(const value& v) { return v.first; }
 };
 
 
-template<class KeyT, class ValueT, class Compare = std::less<KeyT>>
-class Map : public RBTree<MapTraits<KeyT, ValueT, Compare>>
+template<class KeyT, class ValueT, class Compare = std::less<KeyT>,
+		 class Allocator = std::allocator<std::pair<const KeyT, ValueT>>>
+class Map : public RBTree<MapTraits<KeyT, ValueT, Compare, Allocator>>
 {
-	using Tree = RBTree<MapTraits<KeyT, ValueT, Compare>>;
+	using Tree = RBTree<MapTraits<KeyT, ValueT, Compare, Allocator>>;
 public:
 	using Node				 = typename Tree::Node;
 	using MappedType	     = ValueT;
@@ -24,24 +31,30 @@ public:
 	using reverse_iterator   = typename Tree::Reverse_Iterator;
 	using l_iterator		 = typename Tree::l_iterator;
 	using reverse_l_iterator = typename Tree::reverse_l_iterator;
-	using ValueType			 = typename MapTraits<KeyT, ValueT, Compare>::value;
-	using KeyType		     = typename MapTraits<KeyT, ValueT, Compare>::key;	
+	using ValueType			 = typename MapTraits<KeyT, ValueT, Compare, Allocator>::value;
+	using KeyType		     = typename MapTraits<KeyT, ValueT, Compare, Allocator>::key;	
 
 
 	Map(): Tree() {
 
 	}
 
-	Map(const Map& other) : Tree() {
-		for (auto& it : other.list) {
-			insert(it->value);
-		}
+	explicit Map(const Allocator& alloc) : Tree(alloc) {
+
+	}
+
+	Map(const Map& other) : Tree(other.get_allocator()) {
+		this->cloneFrom(other);
 	}
 
 	Map(std::initializer_list<ValueType> init) : Tree() {
-		for (auto it : init) {
-			insert(std::make_pair(it.first, it.second));
-		}
+		this->assignRange(init.begin(), init.end());
+	}
+
+	//O(n) for input sorted by key, O(n log n) otherwise
+	template<class InputIt>
+	Map(InputIt first, InputIt last) : Tree() {
+		this->assignRange(first, last);
 	}
 
 	~Map() {
@@ -50,12 +63,79 @@ public:
 
 	std::pair<iterator, bool> insert(const ValueType& value)
 	{
-		return Tree::insert(value.first, value);
+		return Tree::insert(value);
+	}
+
+	std::pair<iterator, bool> insert(ValueType&& value)
+	{
+		const KeyType& key = value.first;
+		return Tree::insertUnique(key, std::move(value));
+	}
+
+	//hint is where the element is expected to go, the position of its
+	//successor: a correct hint (or the element right before it) skips the
+	//descent from the root, a wrong one costs a few extra comparisons
+	iterator insert(iterator hint, const ValueType& value)
+	{
+		return Tree::insertUniqueHint(hint, value.first, value).first;
+	}
+
+	iterator insert(iterator hint, ValueType&& value)
+	{
+		const KeyType& key = value.first;
+		return Tree::insertUniqueHint(hint, key, std::move(value)).first;
+	}
+
+	template<class... Args>
+	std::pair<iterator, bool> emplace(Args&&... args)
+	{
+		return Tree::emplace(std::forward<Args>(args)...);
+	}
+
+	template<class... Args>
+	iterator emplace_hint(iterator hint, Args&&... args)
+	{
+		return Tree::emplaceHint(hint, std::forward<Args>(args)...).first;
+	}
+
+	//builds the mapped value from args only if key is absent
+	template<class... Args>
+	std::pair<iterator, bool> try_emplace(const KeyType& key, Args&&... args)
+	{
+		return Tree::insertUnique(key, std::piecewise_construct,
+			std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	template<class... Args>
+	std::pair<iterator, bool> try_emplace(KeyType&& key, Args&&... args)
+	{
+		return Tree::insertUnique(key, std::piecewise_construct,
+			std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	template<class... Args>
+	iterator try_emplace(iterator hint, const KeyType& key, Args&&... args)
+	{
+		return Tree::insertUniqueHint(hint, key, std::piecewise_construct,
+			std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...)).first;
 	}
 
+	template<class... Args>
+	iterator try_emplace(iterator hint, KeyType&& key, Args&&... args)
+	{
+		return Tree::insertUniqueHint(hint, key, std::piecewise_construct,
+			std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...)).first;
+	}
+
+	//value-initializes the mapped value only when key is new
 	MappedType& operator[](const KeyType& key)
 	{
-		return insert(key, ValueType()).first->value;
+		return try_emplace(key).first->second;
+	}
+
+	MappedType& operator[](KeyType&& key)
+	{
+		return try_emplace(std::move(key)).first->second;
 	}
 
 
@@ -68,4 +148,48 @@ public:
 		else throw std::out_of_range("invalid map<K, T> key");
 	}
 
+	template<class K> requires rb_transparent<Compare>
+	MappedType& at(const K& key)
+	{
+		Node* node = Tree::search(key);
+		if (node != nullptr) {
+			return node->value.second;
+		}
+		else throw std::out_of_range("invalid map<K, T> key");
+	}
+
 };
+
+//***********parallel set algebra on copies, by key*******************//
+//for keys in both maps the value from a is kept.
+//Map::unite/intersect/subtract work in place and avoid the copies
+
+template<class KeyT, class ValueT, class Compare, class Allocator>
+Map<KeyT, ValueT, Compare, Allocator> set_union(const Map<KeyT, ValueT, Compare, Allocator>& a,
+	const Map<KeyT, ValueT, Compare, Allocator>& b, size_t threads = 0)
+{
+	Map<KeyT, ValueT, Compare, Allocator> result(a);
+	Map<KeyT, ValueT, Compare, Allocator> other(b);
+	result.unite(other, threads);
+	return result;
+}
+
+template<class KeyT, class ValueT, class Compare, class Allocator>
+Map<KeyT, ValueT, Compare, Allocator> set_intersection(const Map<KeyT, ValueT, Compare, Allocator>& a,
+	const Map<KeyT, ValueT, Compare, Allocator>& b, size_t threads = 0)
+{
+	Map<KeyT, ValueT, Compare, Allocator> result(a);
+	Map<KeyT, ValueT, Compare, Allocator> other(b);
+	result.intersect(other, threads);
+	return result;
+}
+
+template<class KeyT, class ValueT, class Compare, class Allocator>
+Map<KeyT, ValueT, Compare, Allocator> set_difference(const Map<KeyT, ValueT, Compare, Allocator>& a,
+	const Map<KeyT, ValueT, Compare, Allocator>& b, size_t threads = 0)
+{
+	Map<KeyT, ValueT, Compare, Allocator> result(a);
+	Map<KeyT, ValueT, Compare, Allocator> other(b);
+	result.subtract(other, threads);
+	return result;
+}
@@ -0,0 +1,365 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+//immutable red-black map: insert, insert_or_assign and erase leave the map
+//untouched and return a new version that copies only the O(log n) nodes on
+//the search path and shares everything else. nodes are reference counted
+//with atomic counters, so versions can be copied in O(1) and handed to
+//other threads; a single persistent_map object is a value like shared_ptr,
+//concurrent reads are fine but assigning to it needs outside synchronisation.
+//insertion follows Okasaki, deletion follows Kahrs.
+template<class KeyT, class ValueT, class Compare = std::less<KeyT>>
+class persistent_map
+{
+public:
+	using KeyType    = KeyT;
+	using MappedType = ValueT;
+	using ValueType  = std::pair<const KeyT, ValueT>;
+
+private:
+	enum colors { RED, BLACK };
+
+	struct Node;
+
+	//owning reference to a node
+	class Ref
+	{
+	private:
+		Node* node = nullptr;
+	public:
+		Ref() { }
+
+		explicit Ref(Node* node) : node(node) { }
+
+		Ref(const Ref& other) : node(other.node)
+		{
+			if (node) node->refs.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		Ref(Ref&& other) noexcept : node(other.node) { other.node = nullptr; }
+
+		Ref& operator=(Ref other) noexcept
+		{
+			std::swap(node, other.node);
+			return *this;
+		}
+
+		~Ref()
+		{
+			if (node && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				delete node;
+			}
+		}
+
+		Node* operator->() const { return node; }
+
+		Node* get() const { return node; }
+
+		explicit operator bool() const { return node != nullptr; }
+	};
+
+	//never modified once built, except for the counter
+	struct Node
+	{
+		Node(bool color, Ref left, const ValueType& value, Ref right)
+			: left(std::move(left)), right(std::move(right)), value(value), color(color)
+		{
+		}
+
+		std::atomic<size_t> refs{ 1 };
+		Ref left;
+		Ref right;
+		ValueType value;
+		bool color;
+	};
+
+	Ref root;
+	size_t _size = 0;
+	Compare comp;
+
+	persistent_map(Ref root, size_t size, const Compare& comp) : root(std::move(root)), _size(size), comp(comp) { }
+
+public:
+	class Iterator
+	{
+		friend class persistent_map;
+	private:
+		std::vector<const Node*> path;		//the current node and its ancestors still to visit
+
+		explicit Iterator(const Node* root) { pushLeft(root); }
+
+		void pushLeft(const Node* node)
+		{
+			for (; node != nullptr; node = node->left.get()) {
+				path.push_back(node);
+			}
+		}
+
+	public:
+		Iterator() { }
+
+		bool operator==(const Iterator& other) const
+		{
+			return current() == other.current();
+		}
+
+		bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+		Iterator& operator++()
+		{
+			const Node* node = path.back();
+			path.pop_back();
+			pushLeft(node->right.get());
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			auto it = *this;
+			++*this;
+			return it;
+		}
+
+		const ValueType& operator*() const { return path.back()->value; }
+
+		const ValueType* operator->() const { return &path.back()->value; }
+
+	private:
+		const Node* current() const { return path.empty() ? nullptr : path.back(); }
+	};
+
+	using iterator = Iterator;
+
+	persistent_map() { }
+
+	explicit persistent_map(const Compare& compare) : comp(compare) { }
+
+	persistent_map(std::initializer_list<ValueType> init)
+	{
+		for (const auto& value : init) {
+			*this = insert(value);
+		}
+	}
+
+	bool empty() const { return _size == 0; }
+
+	size_t size() const { return _size; }
+
+	iterator begin() const { return iterator(root.get()); }
+
+	iterator end() const { return iterator(); }
+
+	//pointer to the mapped value, null if key is absent
+	const MappedType* find(const KeyType& key) const
+	{
+		const Node* node = search(key);
+		return node ? &node->value.second : nullptr;
+	}
+
+	bool contains(const KeyType& key) const { return search(key) != nullptr; }
+
+	size_t count(const KeyType& key) const { return contains(key) ? 1 : 0; }
+
+	const MappedType& at(const KeyType& key) const
+	{
+		const Node* node = search(key);
+		if (node == nullptr) {
+			throw std::out_of_range("invalid persistent_map<K, T> key");
+		}
+		return node->value.second;
+	}
+
+	//new version with value added, or this version if the key is present
+	persistent_map insert(const ValueType& value) const
+	{
+		if (contains(value.first)) return *this;
+		return persistent_map(makeBlack(ins(root, value, false)), _size + 1, comp);
+	}
+
+	//new version mapping key to value, replacing any previous value
+	persistent_map insert_or_assign(const KeyType& key, const MappedType& value) const
+	{
+		bool present = contains(key);
+		return persistent_map(makeBlack(ins(root, ValueType(key, value), present)), _size + !present, comp);
+	}
+
+	//new version without key, or this version if the key is absent
+	persistent_map erase(const KeyType& key) const
+	{
+		if (!contains(key)) return *this;
+		return persistent_map(makeBlack(del(root, key)), _size - 1, comp);
+	}
+
+private:
+	const Node* search(const KeyType& key) const
+	{
+		const Node* curr = root.get();
+		while (curr != nullptr) {
+			if (comp(key, curr->value.first)) {
+				curr = curr->left.get();
+			}
+			else if (comp(curr->value.first, key)) {
+				curr = curr->right.get();
+			}
+			else {
+				return curr;
+			}
+		}
+		return nullptr;
+	}
+
+	static Ref make(bool color, Ref left, const ValueType& value, Ref right)
+	{
+		return Ref(new Node(color, std::move(left), value, std::move(right)));
+	}
+
+	static bool isRed(const Ref& node) { return node && node->color == RED; }
+
+	static bool isBlack(const Ref& node) { return node && node->color == BLACK; }
+
+	static Ref makeBlack(Ref node)
+	{
+		if (!isRed(node)) return node;
+		return make(BLACK, node->left, node->value, node->right);
+	}
+
+	//black node over a and b, rotating away a red child with a red child
+	static Ref balance(const Ref& a, const ValueType& y, const Ref& b)
+	{
+		if (isRed(a) && isRed(b)) {
+			return make(RED, make(BLACK, a->left, a->value, a->right), y,
+							 make(BLACK, b->left, b->value, b->right));
+		}
+		if (isRed(a) && isRed(a->left)) {
+			const Ref& c = a->left;
+			return make(RED, make(BLACK, c->left, c->value, c->right), a->value,
+							 make(BLACK, a->right, y, b));
+		}
+		if (isRed(a) && isRed(a->right)) {
+			const Ref& c = a->right;
+			return make(RED, make(BLACK, a->left, a->value, c->left), c->value,
+							 make(BLACK, c->right, y, b));
+		}
+		if (isRed(b) && isRed(b->right)) {
+			const Ref& c = b->right;
+			return make(RED, make(BLACK, a, y, b->left), b->value,
+							 make(BLACK, c->left, c->value, c->right));
+		}
+		if (isRed(b) && isRed(b->left)) {
+			const Ref& c = b->left;
+			return make(RED, make(BLACK, a, y, c->left), c->value,
+							 make(BLACK, c->right, b->value, b->right));
+		}
+		return make(BLACK, a, y, b);
+	}
+
+	//***********insertion*******************//
+
+	Ref ins(const Ref& node, const ValueType& value, bool assign) const
+	{
+		if (!node) return make(RED, Ref(), value, Ref());
+		if (comp(value.first, node->value.first)) {
+			Ref left = ins(node->left, value, assign);
+			if (node->color == BLACK) return balance(left, node->value, node->right);
+			return make(RED, left, node->value, node->right);
+		}
+		if (comp(node->value.first, value.first)) {
+			Ref right = ins(node->right, value, assign);
+			if (node->color == BLACK) return balance(node->left, node->value, right);
+			return make(RED, node->left, node->value, right);
+		}
+		//only reached with assign, plain inserts of present keys stop earlier
+		return make(node->color, node->left, value, node->right);
+	}
+
+	//***********deletion*******************//
+
+	Ref del(const Ref& node, const KeyType& key) const
+	{
+		if (!node) return Ref();
+		if (comp(key, node->value.first)) {
+			if (isBlack(node->left)) return balanceLeft(del(node->left, key), node->value, node->right);
+			return make(RED, del(node->left, key), node->value, node->right);
+		}
+		if (comp(node->value.first, key)) {
+			if (isBlack(node->right)) return balanceRight(node->left, node->value, del(node->right, key));
+			return make(RED, node->left, node->value, del(node->right, key));
+		}
+		return fuse(node->left, node->right);
+	}
+
+	//the left side lost one black level
+	static Ref balanceLeft(const Ref& left, const ValueType& x, const Ref& right)
+	{
+		if (isRed(left)) {
+			return make(RED, make(BLACK, left->left, left->value, left->right), x, right);
+		}
+		if (isBlack(right)) {
+			return balance(left, x, make(RED, right->left, right->value, right->right));
+		}
+		if (isRed(right) && isBlack(right->left)) {
+			const Ref& c = right->left;
+			return make(RED, make(BLACK, left, x, c->left), c->value,
+							 balance(c->right, right->value, redden(right->right)));
+		}
+		throw std::logic_error("persistent_map: red-black invariant violated");
+	}
+
+	//the right side lost one black level
+	static Ref balanceRight(const Ref& left, const ValueType& x, const Ref& right)
+	{
+		if (isRed(right)) {
+			return make(RED, left, x, make(BLACK, right->left, right->value, right->right));
+		}
+		if (isBlack(left)) {
+			return balance(make(RED, left->left, left->value, left->right), x, right);
+		}
+		if (isRed(left) && isBlack(left->right)) {
+			const Ref& c = left->right;
+			return make(RED, balance(redden(left->left), left->value, c->left), c->value,
+							 make(BLACK, c->right, x, right));
+		}
+		throw std::logic_error("persistent_map: red-black invariant violated");
+	}
+
+	static Ref redden(const Ref& node)
+	{
+		if (!isBlack(node)) {
+			throw std::logic_error("persistent_map: red-black invariant violated");
+		}
+		return make(RED, node->left, node->value, node->right);
+	}
+
+	//joins the two subtrees of a removed node, all keys of a < all keys of b
+	static Ref fuse(const Ref& a, const Ref& b)
+	{
+		if (!a) return b;
+		if (!b) return a;
+		if (isRed(a) && isRed(b)) {
+			Ref middle = fuse(a->right, b->left);
+			if (isRed(middle)) {
+				return make(RED, make(RED, a->left, a->value, middle->left), middle->value,
+								 make(RED, middle->right, b->value, b->right));
+			}
+			return make(RED, a->left, a->value, make(RED, middle, b->value, b->right));
+		}
+		if (isBlack(a) && isBlack(b)) {
+			Ref middle = fuse(a->right, b->left);
+			if (isRed(middle)) {
+				return make(RED, make(BLACK, a->left, a->value, middle->left), middle->value,
+								 make(BLACK, middle->right, b->value, b->right));
+			}
+			return balanceLeft(a->left, a->value, make(BLACK, middle, b->value, b->right));
+		}
+		if (isRed(b)) {
+			return make(RED, fuse(a, b->left), b->value, b->right);
+		}
+		return make(RED, a->left, a->value, fuse(a->right, b));
+	}
+};
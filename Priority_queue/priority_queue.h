@@ -0,0 +1,324 @@
+#ifndef PRIORITY_QUEUE_H
+#define PRIORITY_QUEUE_H
+
+#include "../vector/my_vector.h"
+
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+//  d-ary heap over vector, children of i are Arity * i + 1 ... Arity * i + Arity.
+//  with the default 4 children a node's children usually share one cache line
+//  and the tree is half as deep as a binary heap.
+//  like std::priority_queue, top() is the largest element under Compare.
+template<class T, class Compare = std::less<T>, size_t Arity = 4>
+class priority_queue
+{
+    static_assert(Arity >= 2, "heap arity must be at least 2");
+
+    vector<T> heap;
+    Compare comp;
+
+public:
+    priority_queue() {}
+
+    explicit priority_queue(const Compare& compare) : comp(compare) {}
+
+    //  bulk construction, O(n) bottom-up heapify
+    template<class InputIt>
+    priority_queue(InputIt first, InputIt last, const Compare& compare = Compare()) : comp(compare)
+    {
+        for (; first != last; ++first) {
+            heap.push_back(*first);
+        }
+        heapify();
+    }
+
+    priority_queue(std::initializer_list<T> init, const Compare& compare = Compare())
+        : priority_queue(init.begin(), init.end(), compare)
+    {
+    }
+
+    const T& top() const { return heap[0]; }
+
+    size_t size() const { return heap.size(); }
+
+    bool empty() const { return heap.empty(); }
+
+    void push(const T& value)
+    {
+        heap.push_back(value);
+        sift_up(heap.size() - 1);
+    }
+
+    void push(T&& value)
+    {
+        heap.push_back(std::move(value));
+        sift_up(heap.size() - 1);
+    }
+
+    template<class... Args>
+    void emplace(Args&&... args)
+    {
+        heap.emplace_back(std::forward<Args>(args)...);
+        sift_up(heap.size() - 1);
+    }
+
+    //  append a range and restore the heap once: O(n + k) instead of O(k log n)
+    //  when the range is large compared to the heap.
+    template<class InputIt>
+    void push_range(InputIt first, InputIt last)
+    {
+        size_t old_size = heap.size();
+        for (; first != last; ++first) {
+            heap.push_back(*first);
+        }
+        size_t added = heap.size() - old_size;
+        if (added > old_size) {
+            heapify();
+        }
+        else {
+            for (size_t i = old_size; i < heap.size(); ++i) {
+                sift_up(i);
+            }
+        }
+    }
+
+    void pop()
+    {
+        if (heap.size() > 1) {
+            heap[0] = std::move(heap.back());
+        }
+        heap.pop_back();
+        if (!heap.empty()) {
+            sift_down(0);
+        }
+    }
+
+    void clear() { heap.clear(); }
+
+    void swap(priority_queue& other)
+    {
+        heap.swap(other.heap);
+        std::swap(comp, other.comp);
+    }
+
+private:
+    static size_t parent(size_t i) { return (i - 1) / Arity; }
+
+    static size_t first_child(size_t i) { return Arity * i + 1; }
+
+    void heapify()
+    {
+        if (heap.size() < 2) return;
+        for (size_t i = parent(heap.size() - 1) + 1; i-- > 0;) {
+            sift_down(i);
+        }
+    }
+
+    //  move the element at i up, shifting parents into the hole
+    void sift_up(size_t i)
+    {
+        T value = std::move(heap[i]);
+        while (i > 0) {
+            size_t p = parent(i);
+            if (!comp(heap[p], value)) break;
+            heap[i] = std::move(heap[p]);
+            i = p;
+        }
+        heap[i] = std::move(value);
+    }
+
+    //  move the element at i down, shifting the best child into the hole
+    void sift_down(size_t i)
+    {
+        size_t n = heap.size();
+        T value = std::move(heap[i]);
+        for (;;) {
+            size_t child = first_child(i);
+            if (child >= n) break;
+            size_t last = child + Arity < n ? child + Arity : n;
+            size_t best = child;
+            for (size_t c = child + 1; c < last; ++c) {
+                if (comp(heap[best], heap[c])) best = c;
+            }
+            if (!comp(value, heap[best])) break;
+            heap[i] = std::move(heap[best]);
+            i = best;
+        }
+        heap[i] = std::move(value);
+    }
+};
+
+//  d-ary heap whose elements are addressed by handles returned from push(),
+//  so a queued element can be re-prioritized or removed in O(log n).
+//  handles of popped or erased elements are reused by later pushes.
+template<class T, class Compare = std::less<T>, size_t Arity = 4>
+class indexed_priority_queue
+{
+    static_assert(Arity >= 2, "heap arity must be at least 2");
+
+public:
+    using handle = size_t;
+    static constexpr handle npos = static_cast<handle>(-1);
+
+private:
+    struct entry
+    {
+        T value;
+        handle id;
+    };
+
+    vector<entry> heap;
+    vector<size_t> position;    //  heap index of every handle, npos if free
+    vector<handle> free_handles;
+    Compare comp;
+
+public:
+    indexed_priority_queue() {}
+
+    explicit indexed_priority_queue(const Compare& compare) : comp(compare) {}
+
+    const T& top() const { return heap[0].value; }
+
+    handle top_handle() const { return heap[0].id; }
+
+    size_t size() const { return heap.size(); }
+
+    bool empty() const { return heap.empty(); }
+
+    bool contains(handle h) const { return h < position.size() && position[h] != npos; }
+
+    const T& value(handle h) const { return heap[checked_position(h)].value; }
+
+    handle push(const T& value) { return emplace(value); }
+
+    handle push(T&& value) { return emplace(std::move(value)); }
+
+    template<class... Args>
+    handle emplace(Args&&... args)
+    {
+        handle h;
+        if (free_handles.empty()) {
+            h = position.size();
+            position.push_back(npos);
+        }
+        else {
+            h = free_handles.back();
+            free_handles.pop_back();
+        }
+        heap.push_back(entry{ T(std::forward<Args>(args)...), h });
+        position[h] = heap.size() - 1;
+        sift_up(heap.size() - 1);
+        return h;
+    }
+
+    void pop()
+    {
+        remove_at(0);
+    }
+
+    void erase(handle h)
+    {
+        remove_at(checked_position(h));
+    }
+
+    //  the new value must not be further from the top than the old one
+    //  (smaller priority under Compare), it can only move up.
+    void decrease_key(handle h, const T& value)
+    {
+        size_t i = checked_position(h);
+        if (comp(value, heap[i].value)) {
+            throw std::invalid_argument("decrease_key would move the element away from the top");
+        }
+        heap[i].value = value;
+        sift_up(i);
+    }
+
+    //  set any new value, moving the element up or down as needed
+    void update(handle h, const T& value)
+    {
+        size_t i = checked_position(h);
+        bool up = comp(heap[i].value, value);
+        heap[i].value = value;
+        if (up) sift_up(i);
+        else sift_down(i);
+    }
+
+    void clear()
+    {
+        heap.clear();
+        position.clear();
+        free_handles.clear();
+    }
+
+private:
+    static size_t parent(size_t i) { return (i - 1) / Arity; }
+
+    static size_t first_child(size_t i) { return Arity * i + 1; }
+
+    size_t checked_position(handle h) const
+    {
+        if (!contains(h)) {
+            throw std::out_of_range("invalid priority queue handle");
+        }
+        return position[h];
+    }
+
+    void remove_at(size_t i)
+    {
+        handle h = heap[i].id;
+        size_t last = heap.size() - 1;
+        if (i != last) {
+            heap[i] = std::move(heap[last]);
+            position[heap[i].id] = i;
+        }
+        heap.pop_back();
+        position[h] = npos;
+        free_handles.push_back(h);
+        if (i < heap.size()) {
+            if (i > 0 && comp(heap[parent(i)].value, heap[i].value)) sift_up(i);
+            else sift_down(i);
+        }
+    }
+
+    void place(size_t i, entry&& e)
+    {
+        heap[i] = std::move(e);
+        position[heap[i].id] = i;
+    }
+
+    void sift_up(size_t i)
+    {
+        entry e = std::move(heap[i]);
+        while (i > 0) {
+            size_t p = parent(i);
+            if (!comp(heap[p].value, e.value)) break;
+            place(i, std::move(heap[p]));
+            i = p;
+        }
+        place(i, std::move(e));
+    }
+
+    void sift_down(size_t i)
+    {
+        size_t n = heap.size();
+        entry e = std::move(heap[i]);
+        for (;;) {
+            size_t child = first_child(i);
+            if (child >= n) break;
+            size_t last = child + Arity < n ? child + Arity : n;
+            size_t best = child;
+            for (size_t c = child + 1; c < last; ++c) {
+                if (comp(heap[best].value, heap[c].value)) best = c;
+            }
+            if (!comp(e.value, heap[best].value)) break;
+            place(i, std::move(heap[best]));
+            i = best;
+        }
+        place(i, std::move(e));
+    }
+};
+
+#endif // PRIORITY_QUEUE_H
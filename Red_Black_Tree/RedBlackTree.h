@@ -1,11 +1,44 @@
 #pragma once
 
+#include <algorithm>
 #include <functional>
-#include <list>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <span>
+#include <thread>
 #include <type_traits>
+#include <utility>
 #include <iostream>
+#include <vector>
 
 
+//traits may add a subtree summary: a summary_type and a static
+//summarize(value, left, right) folding a node's value with the summaries
+//of its children (null where a child is missing). every node keeps the
+//summary of its subtree, refreshed by RBTree::update()
+template<class Traits>
+struct rb_summary
+{
+	struct type { };
+	static constexpr bool enabled = false;
+};
+
+template<class Traits>
+	requires requires { typename Traits::summary_type; }
+struct rb_summary<Traits>
+{
+	using type = typename Traits::summary_type;
+	static constexpr bool enabled = true;
+};
+
+//comparators declaring is_transparent accept any key type they can compare,
+//lookups then take that type as is instead of building a KeyType first
+template<class Compare>
+concept rb_transparent = requires { typename Compare::is_transparent; };
 
 template<class Traits>
 class RBTree
@@ -14,6 +47,7 @@ public:
 	using KeyType		  = typename Traits::key;
 	using ValueType		  = typename Traits::value;
 	using key_compare     	  = typename Traits::key_compare;
+	using allocator_type	  = typename Traits::allocator_type;
 	using reference		  = ValueType&;
 	using const_reference     = const ValueType&;
 
@@ -23,6 +57,7 @@ public:
 	class L_Iterator;
 	class reverse_l_iterator;
 	class Const_L_Iterator;
+	class Range;
 
 	using iterator = std::conditional_t<std::is_same_v<KeyType, ValueType>, Const_Iterator, Iterator>;
 	using l_iterator = std::conditional_t<std::is_same_v<KeyType, ValueType>, Const_L_Iterator, L_Iterator>;
@@ -34,43 +69,200 @@ protected:
 	struct Node
 	{
 		Node() {}
-		Node(const KeyType& key, const ValueType& value)
-			: key(key), value(value)
+		explicit Node(const ValueType& value)
+			: value(value)
+		{
+
+		}
+		template<class... Args>
+		explicit Node(std::in_place_t, Args&&... args)
+			: value(std::forward<Args>(args)...)
 		{
 
 		}
 		Node* parent = nullptr;
 		Node* left = nullptr;
 		Node* right = nullptr;
+		Node* prev = nullptr;	//in-order neighbours, threaded through the tree
+		Node* next = nullptr;
 
-		KeyType key;
-		ValueType value;
+		ValueType value;		//the key is read from it through Traits::get_key
 
+		size_t size = 1;		//nodes in the subtree rooted here
+		[[no_unique_address]] typename rb_summary<Traits>::type summary;
 		bool color = BLACK;
 	};
 
-	void insertToList(std::list<Node*>& list, Node* node) {
-		if (list.empty()) list.push_back(node);
+	static const KeyType& keyOf(const Node* node) { return Traits::get_key(node->value); }
+
+	static size_t sizeOf(const Node* node) { return node ? node->size : 0; }
+
+	//hint only, a no-op where the compiler has no prefetch builtin
+	static void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+		__builtin_prefetch(address);
+#else
+		(void)address;
+#endif
+	}
+
+	//recomputes the augmented fields of node from its children,
+	//called bottom-up wherever the shape of the tree changes
+	static void update(Node* node) {
+		node->size = 1 + sizeOf(node->left) + sizeOf(node->right);
+		if constexpr (rb_summary<Traits>::enabled) {
+			node->summary = Traits::summarize(node->value,
+				node->left ? &node->left->summary : nullptr,
+				node->right ? &node->right->summary : nullptr);
+		}
+	}
+
+	//link a freshly attached leaf into the in-order thread, O(1):
+	//a left child precedes its parent, a right child follows it
+	void linkToThread(Node* node) {
+		Node* parent = node->parent;
+		if (parent == nullptr) {
+			head = tail = node;
+		}
+		else if (node == parent->left) {
+			node->next = parent;
+			node->prev = parent->prev;
+			if (parent->prev) parent->prev->next = node;
+			else head = node;
+			parent->prev = node;
+		}
 		else {
-			auto it = list.begin();
-			while (it != list.end() && comp((*it)->key, node->key)) ++it;
-			list.insert(it, node);
+			node->prev = parent;
+			node->next = parent->next;
+			if (parent->next) parent->next->prev = node;
+			else tail = node;
+			parent->next = node;
 		}
 	}
 
-	void removeFromList(std::list<Node*>& list, Node* node) {
-		for (auto it = list.begin(); it != list.end(); ++it) {
-			if (*it == node) {
-				list.erase(it);
-				return;
+	//nodes are carved out of slabs of raw storage obtained from the
+	//allocator; erased nodes go to a free list for reuse and all slabs
+	//are returned together by clear() and the destructor
+	class NodePool
+	{
+	public:
+		using node_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<Node>;
+		using alloc_traits   = std::allocator_traits<node_allocator>;
+
+		static constexpr size_t min_slab = 32;
+		static constexpr size_t max_slab = 4096;
+
+		explicit NodePool(const allocator_type& alloc = allocator_type()) : alloc(alloc) { }
+
+		NodePool(const NodePool&) = delete;
+
+		NodePool& operator=(const NodePool&) = delete;
+
+		~NodePool() { release(); }
+
+		template<class... Args>
+		Node* create(Args&&... args) {
+			Node* node = take();
+			try {
+				alloc_traits::construct(alloc, node, std::forward<Args>(args)...);
+			}
+			catch (...) {
+				giveBack(node);
+				throw;
+			}
+			return node;
+		}
+
+		void destroy(Node* node) {
+			alloc_traits::destroy(alloc, node);
+			giveBack(node);
+		}
+
+		//destructor only, for nodes whose storage is about to be released
+		void destroyInPlace(Node* node) {
+			alloc_traits::destroy(alloc, node);
+		}
+
+		//frees every slab, live nodes must have been destroyed already
+		void release() {
+			for (auto& slab : slabs) {
+				alloc_traits::deallocate(alloc, slab.first, slab.second);
+			}
+			slabs.clear();
+			free_list = nullptr;
+			slab_used = slab_capacity = 0;
+		}
+
+		//takes over the slabs and free nodes of other, whose allocator must
+		//compare equal; nodes created by other are then released by this pool
+		void adopt(NodePool& other) {
+			if (slabs.empty()) {
+				slabs.swap(other.slabs);
+				slab_used = other.slab_used;
+				slab_capacity = other.slab_capacity;
+			}
+			else {
+				//the last slab is the one still being carved, keep it last
+				slabs.insert(slabs.begin(), other.slabs.begin(), other.slabs.end());
+				other.slabs.clear();
 			}
+			if (other.free_list) {
+				FreeNode* last = other.free_list;
+				while (last->next) last = last->next;
+				last->next = free_list;
+				free_list = other.free_list;
+			}
+			other.free_list = nullptr;
+			other.slab_used = other.slab_capacity = 0;
+		}
+
+		allocator_type get_allocator() const { return allocator_type(alloc); }
+
+	private:
+		struct FreeNode { FreeNode* next; };
+
+		Node* take() {
+			if (free_list) {
+				FreeNode* free_node = free_list;
+				free_list = free_node->next;
+				return reinterpret_cast<Node*>(free_node);
+			}
+			if (slab_used == slab_capacity) grow();
+			return slabs.back().first + slab_used++;
 		}
+
+		void giveBack(Node* node) {
+			free_list = ::new (static_cast<void*>(node)) FreeNode{ free_list };
+		}
+
+		void grow() {
+			size_t count = slabs.empty() ? min_slab : std::min(slabs.back().second * 2, max_slab);
+			slabs.reserve(slabs.size() + 1);
+			slabs.emplace_back(alloc_traits::allocate(alloc, count), count);
+			slab_used = 0;
+			slab_capacity = count;
+		}
+
+		node_allocator alloc;
+		std::vector<std::pair<Node*, size_t>> slabs;
+		FreeNode* free_list = nullptr;
+		size_t slab_used = 0;
+		size_t slab_capacity = 0;
+	};
+
+	void unlinkFromThread(Node* node) {
+		if (node->prev) node->prev->next = node->next;
+		else head = node->next;
+		if (node->next) node->next->prev = node->prev;
+		else tail = node->prev;
 	}
 
 protected:
 
+	NodePool pool;
 	Node* root = nullptr;
-	std::list<Node*> list;
+	Node* head = nullptr;	//smallest node, start of the in-order thread
+	Node* tail = nullptr;	//largest node
 	size_t _size = 0;
 
 
@@ -80,46 +272,49 @@ public:
 	{
 	}
 
+	explicit RBTree(const allocator_type& alloc) : pool(alloc)
+	{
+	}
+
 	~RBTree()
 	{
-		deleteTree(root);
+		destroyNodes();
 	}
 
+	allocator_type get_allocator() const { return pool.get_allocator(); }
+
 
 
 
 
 	bool erase(const KeyType& key) {
-		Node* node = root;
-		Node* z = nullptr;
-		Node* x, *y;
-		while (node != nullptr) {
-			if (node->key == key) {
-				z = node;
-				break;
-			}
+		return eraseNode(search(key));
+	}
 
-			if (node->key < key) {
-				node = node->right;
-			}
-			else {
-				node = node->left;
-			}
-		}
+	template<class K> requires rb_transparent<key_compare>
+	bool erase(const K& key) {
+		return eraseNode(search(key));
+	}
 
+	bool eraseNode(Node* z) {
 		if (z == nullptr) {
-			std::cout << "Key not found in the tree" << std::endl;
 			return false;
 		}
 
-		y = z;
-		int y_original_color = y->color;
+		unlinkFromThread(z);
+
+		Node* y = z;
+		Node* x;
+		Node* x_parent;		//x may be null, so its parent is tracked separately
+		bool y_original_color = y->color;
 		if (z->left == nullptr) {
 			x = z->right;
+			x_parent = z->parent;
 			rbTransplant(z, z->right);
 		}
 		else if (z->right == nullptr) {
 			x = z->left;
+			x_parent = z->parent;
 			rbTransplant(z, z->left);
 		}
 		else {
@@ -127,9 +322,10 @@ public:
 			y_original_color = y->color;
 			x = y->right;
 			if (y->parent == z) {
-				x->parent = y;
+				x_parent = y;
 			}
 			else {
+				x_parent = y->parent;
 				rbTransplant(y, y->right);
 				y->right = z->right;
 				y->right->parent = y;
@@ -140,9 +336,13 @@ public:
 			y->left->parent = y;
 			y->color = z->color;
 		}
-		delete z;
-		if (y_original_color == 0) {
-			delete_fixup(x);
+		pool.destroy(z);
+		--_size;
+		for (Node* node = x_parent; node != nullptr; node = node->parent) {
+			update(node);
+		}
+		if (y_original_color == BLACK) {
+			delete_fixup(x, x_parent);
 		}
 		return true;
 	}
@@ -155,9 +355,10 @@ public:
 
 	void clear()
 	{
-		deleteTree(root);
+		destroyNodes();
+		pool.release();
 		root = nullptr;
-		list.clear();
+		head = tail = nullptr;
 		_size = 0;
 	}
 
@@ -172,21 +373,181 @@ public:
 		return (search(key) == nullptr ? 0 : 1);
 	}
 
+	template<class K> requires rb_transparent<key_compare>
+	size_t count(const K& key)
+	{
+		return (search(key) == nullptr ? 0 : 1);
+	}
+
+	bool contains(const KeyType& key)
+	{
+		return search(key) != nullptr;
+	}
+
+	template<class K> requires rb_transparent<key_compare>
+	bool contains(const K& key)
+	{
+		return search(key) != nullptr;
+	}
+
 	iterator find(const KeyType& key)
 	{
 		auto it = search(key);
 		return iterator(it, this);
 	}
 
+	template<class K> requires rb_transparent<key_compare>
+	iterator find(const K& key)
+	{
+		return iterator(search(key), this);
+	}
+
+	//first element not less than key
+	iterator lower_bound(const KeyType& key)
+	{
+		return iterator(lowerBoundNode(key), this);
+	}
+
+	template<class K> requires rb_transparent<key_compare>
+	iterator lower_bound(const K& key)
+	{
+		return iterator(lowerBoundNode(key), this);
+	}
+
+	//first element greater than key
+	iterator upper_bound(const KeyType& key)
+	{
+		return iterator(upperBoundNode(key), this);
+	}
+
+	template<class K> requires rb_transparent<key_compare>
+	iterator upper_bound(const K& key)
+	{
+		return iterator(upperBoundNode(key), this);
+	}
+
+	std::pair<iterator, iterator> equal_range(const KeyType& key)
+	{
+		return equalRange(key);
+	}
+
+	template<class K> requires rb_transparent<key_compare>
+	std::pair<iterator, iterator> equal_range(const K& key)
+	{
+		return equalRange(key);
+	}
+
+	//keys searched side by side by find_many
+	static constexpr size_t find_many_lanes = 16;
+
+	//result i is find(keys[i]). the keys go down the tree in groups that
+	//advance one level per key per round, so the cache misses of the
+	//different descents overlap instead of queueing behind each other;
+	//worth it once the tree no longer fits in cache
+	std::vector<iterator> find_many(std::span<const KeyType> keys)
+	{
+		std::vector<iterator> result;
+		result.reserve(keys.size());
+		Node* found[find_many_lanes];
+		for (size_t first = 0; first < keys.size(); first += find_many_lanes) {
+			size_t count = std::min(find_many_lanes, keys.size() - first);
+			searchLockstep(keys.data() + first, count, found);
+			for (size_t i = 0; i < count; ++i) {
+				result.push_back(iterator(found[i], this));
+			}
+		}
+		return result;
+	}
+
+	//elements with keys in [lo, hi), walked along the in-order thread
+	Range range(const KeyType& lo, const KeyType& hi)
+	{
+		Node* first = lowerBoundNode(lo);
+		Node* last = lowerBoundNode(hi);
+		if (!comp(lo, hi)) last = first;
+		return Range(l_iterator(first, this), l_iterator(last, this));
+	}
+
+	//***********order statistics, O(log n)*******************//
+
+	//number of elements with keys less than key
+	size_t rank(const KeyType& key) const
+	{
+		size_t result = 0;
+		Node* curr = root;
+		while (curr != nullptr) {
+			if (comp(keyOf(curr), key)) {
+				result += sizeOf(curr->left) + 1;
+				curr = curr->right;
+			}
+			else {
+				curr = curr->left;
+			}
+		}
+		return result;
+	}
+
+	//k-th smallest element counting from 0, end() if k >= size()
+	iterator select(size_t k)
+	{
+		Node* curr = root;
+		while (curr != nullptr) {
+			size_t left_size = sizeOf(curr->left);
+			if (k < left_size) {
+				curr = curr->left;
+			}
+			else if (k == left_size) {
+				break;
+			}
+			else {
+				k -= left_size + 1;
+				curr = curr->right;
+			}
+		}
+		return iterator(curr, this);
+	}
+
+	//number of elements with keys in [lo, hi)
+	size_t count_range(const KeyType& lo, const KeyType& hi) const
+	{
+		if (!comp(lo, hi)) return 0;
+		return rank(hi) - rank(lo);
+	}
+
+	//***********set algebra*******************//
+	//in place, built on join/split: this tree receives the result and takes
+	//over the nodes of other, which is left empty; both trees must use equal
+	//allocators. O(m log(n / m + 1)) work for sizes m <= n, the two recursive
+	//halves run in parallel down to log2(threads) levels (0 = hardware concurrency).
+	//for equal keys the element of this tree is kept
+
+	void unite(RBTree& other, size_t threads = 0)
+	{
+		combineWith(other, SetOperation::Union, threads);
+	}
+
+	void intersect(RBTree& other, size_t threads = 0)
+	{
+		combineWith(other, SetOperation::Intersection, threads);
+	}
+
+	void subtract(RBTree& other, size_t threads = 0)
+	{
+		combineWith(other, SetOperation::Difference, threads);
+	}
+
 protected:
-    Node* search(const KeyType& key)
+	//the lookup helpers take any K: the public overloads only pass types
+	//other than KeyType when the comparator is transparent
+	template<class K>
+    Node* search(const K& key)
     {
         Node* curr = root;
         while (curr != nullptr) {
-            if (comp(curr->key, key)) {
+            if (comp(keyOf(curr), key)) {
                 curr = curr->right;
             }
-            else if (comp(key, curr->key)) {
+            else if (comp(key, keyOf(curr))) {
                 curr = curr->left;
             }
             else {
@@ -196,41 +557,232 @@ protected:
         return nullptr;
     }
 
-	std::pair<iterator, bool> insert(const KeyType& key, const ValueType& value = ValueType())
+	template<class K>
+	Node* lowerBoundNode(const K& key) const
 	{
-		Node* new_node = new Node(key, value);
-		Node* parent = nullptr;
+		Node* result = nullptr;
+		Node* curr = root;
+		while (curr != nullptr) {
+			if (comp(keyOf(curr), key)) {
+				curr = curr->right;
+			}
+			else {
+				result = curr;
+				curr = curr->left;
+			}
+		}
+		return result;
+	}
+
+	template<class K>
+	Node* upperBoundNode(const K& key) const
+	{
+		Node* result = nullptr;
+		Node* curr = root;
+		while (curr != nullptr) {
+			if (comp(key, keyOf(curr))) {
+				result = curr;
+				curr = curr->left;
+			}
+			else {
+				curr = curr->right;
+			}
+		}
+		return result;
+	}
+
+	//up to find_many_lanes descents interleaved: every step prefetches the
+	//child it moves to, and the other lanes run before that lane is back
+	void searchLockstep(const KeyType* keys, size_t count, Node** found) const
+	{
+		Node* curr[find_many_lanes];
+		size_t lanes[find_many_lanes];		//lanes still descending, unordered
+		for (size_t i = 0; i < count; ++i) {
+			curr[i] = root;
+			lanes[i] = i;
+			found[i] = nullptr;
+		}
+		size_t active = root ? count : 0;
+		while (active > 0) {
+			for (size_t j = 0; j < active; ) {
+				size_t i = lanes[j];
+				Node* node = curr[i];
+				if (comp(keyOf(node), keys[i])) {
+					node = node->right;
+				}
+				else if (comp(keys[i], keyOf(node))) {
+					node = node->left;
+				}
+				else {
+					found[i] = node;
+					node = nullptr;
+				}
+				if (node == nullptr) {
+					lanes[j] = lanes[--active];
+					continue;
+				}
+				prefetch(node);
+				prefetch(&keyOf(node));
+				curr[i] = node;
+				++j;
+			}
+		}
+	}
+
+	template<class K>
+	std::pair<iterator, iterator> equalRange(const K& key)
+	{
+		Node* first = lowerBoundNode(key);
+		Node* last = (first != nullptr && !comp(key, keyOf(first))) ? first->next : first;
+		return std::make_pair(iterator(first, this), iterator(last, this));
+	}
+
+	std::pair<iterator, bool> insert(const ValueType& value)
+	{
+		return insertUnique(Traits::get_key(value), value);
+	}
+
+	//builds the element from args only once key is known to be absent
+	template<class... Args>
+	std::pair<iterator, bool> insertUnique(const KeyType& key, Args&&... args)
+	{
+		Node* parent;
+		bool to_left;
+		if (Node* found = findSlot(key, parent, to_left)) {
+			return std::make_pair(iterator(found, this), false);
+		}
+		Node* new_node = pool.create(std::in_place, std::forward<Args>(args)...);
+		attach(new_node, parent, to_left);
+		return std::make_pair(iterator(new_node, this), true);
+	}
+
+	template<class... Args>
+	std::pair<iterator, bool> insertUniqueHint(iterator hint, const KeyType& key, Args&&... args)
+	{
+		Node* parent;
+		bool to_left;
+		if (Node* found = findSlot(hint.node, key, parent, to_left)) {
+			return std::make_pair(iterator(found, this), false);
+		}
+		Node* new_node = pool.create(std::in_place, std::forward<Args>(args)...);
+		attach(new_node, parent, to_left);
+		return std::make_pair(iterator(new_node, this), true);
+	}
+
+	//the key is only known once the element is built, so the node is
+	//created up front and given back if the key turns out to be present
+	template<class... Args>
+	std::pair<iterator, bool> emplace(Args&&... args)
+	{
+		Node* new_node = pool.create(std::in_place, std::forward<Args>(args)...);
+		Node* parent;
+		bool to_left;
+		if (Node* found = findSlot(keyOf(new_node), parent, to_left)) {
+			pool.destroy(new_node);
+			return std::make_pair(iterator(found, this), false);
+		}
+		attach(new_node, parent, to_left);
+		return std::make_pair(iterator(new_node, this), true);
+	}
+
+	template<class... Args>
+	std::pair<iterator, bool> emplaceHint(iterator hint, Args&&... args)
+	{
+		Node* new_node = pool.create(std::in_place, std::forward<Args>(args)...);
+		Node* parent;
+		bool to_left;
+		if (Node* found = findSlot(hint.node, keyOf(new_node), parent, to_left)) {
+			pool.destroy(new_node);
+			return std::make_pair(iterator(found, this), false);
+		}
+		attach(new_node, parent, to_left);
+		return std::make_pair(iterator(new_node, this), true);
+	}
+
+	//descends from the root; returns the node holding key, or null with
+	//parent and to_left naming the empty slot where key belongs
+	Node* findSlot(const KeyType& key, Node*& parent, bool& to_left) const
+	{
+		parent = nullptr;
+		to_left = false;
 		Node* curr = root;
 		while (curr != nullptr) {
 			parent = curr;
-			if (comp(key, curr->key)) {
+			if (comp(key, keyOf(curr))) {
 				curr = curr->left;
+				to_left = true;
 			}
-			else if (comp(curr->key, key)) {
+			else if (comp(keyOf(curr), key)) {
 				curr = curr->right;
+				to_left = false;
 			}
 			else {
-				return std::make_pair(iterator(curr, this), false);
+				return curr;
+			}
+		}
+		return nullptr;
+	}
+
+	//same, but first tries the gaps just before and just after hint
+	//(null for end()): O(1) comparisons when keys arrive in order
+	Node* findSlot(Node* hint, const KeyType& key, Node*& parent, bool& to_left) const
+	{
+		Node* before = hint ? hint->prev : tail;
+		if (hint == nullptr || comp(key, keyOf(hint))) {
+			if (before == nullptr || comp(keyOf(before), key)) {
+				gapSlot(before, hint, parent, to_left);
+				return nullptr;
 			}
 		}
+		else if (!comp(keyOf(hint), key)) {
+			return hint;
+		}
+		else if (hint->next == nullptr || comp(key, keyOf(hint->next))) {
+			gapSlot(hint, hint->next, parent, to_left);
+			return nullptr;
+		}
+		return findSlot(key, parent, to_left);
+	}
+
+	//empty slot between in-order neighbours a and b, either may be null:
+	//the left child of b if free, else the right child of a, which then
+	//is the largest node under b->left and has no right child
+	static void gapSlot(Node* a, Node* b, Node*& parent, bool& to_left)
+	{
+		if (b != nullptr && b->left == nullptr) {
+			parent = b;
+			to_left = true;
+		}
+		else {
+			parent = a;
+			to_left = false;
+		}
+	}
+
+	//hangs a new node in the slot found by findSlot and rebalances.
+	//the comparisons are done by then; what is left is the walk refreshing
+	//subtree sizes up to the root and O(1) amortized rotations
+	void attach(Node* new_node, Node* parent, bool to_left)
+	{
 		new_node->parent = parent;
 		if (parent == nullptr) {
 			this->root = new_node;
 		}
-		else if (comp(key, parent->key)) {
+		else if (to_left) {
 			parent->left = new_node;
 		}
 		else parent->right = new_node;
 
 		new_node->color = RED;
+		for (Node* node = new_node; node != nullptr; node = node->parent) {
+			update(node);
+		}
 
-		insert_fixup(new_node);
+		linkToThread(new_node);
 
-		insertToList(list, new_node);
+		insert_fixup(new_node);
 
 		++_size;
-
-		return std::make_pair(iterator(new_node, this), true);
 	}
 
 	void rbTransplant(Node* u, Node* v) {
@@ -246,10 +798,129 @@ protected:
 		if(v) v->parent = u->parent;
 	}
 
+	//***********bulk construction*******************//
+
+	//replaces the contents with a range in O(n) when its keys are already
+	//strictly increasing, otherwise sorts pointers to the elements first;
+	//of several equal keys the first one is kept, as with insert.
+	//single-pass ranges and other element types are copied into a vector first
+	template<class InputIt>
+	void assignRange(InputIt first, InputIt last)
+	{
+		using category = typename std::iterator_traits<InputIt>::iterator_category;
+		using element = typename std::iterator_traits<InputIt>::value_type;
+		if constexpr (!std::is_base_of_v<std::forward_iterator_tag, category> || !std::is_same_v<element, ValueType>) {
+			std::vector<ValueType> values(first, last);
+			assignRange(values.begin(), values.end());
+		}
+		else {
+			clear();
+			auto less = [&](const ValueType& a, const ValueType& b) { return comp(Traits::get_key(a), Traits::get_key(b)); };
+			if (std::adjacent_find(first, last, std::not_fn(less)) == last) {
+				buildFromSorted(first, std::distance(first, last));
+				return;
+			}
+			std::vector<const ValueType*> sorted;
+			for (; first != last; ++first) {
+				sorted.push_back(&*first);
+			}
+			std::stable_sort(sorted.begin(), sorted.end(),
+				[&](const ValueType* a, const ValueType* b) { return less(*a, *b); });
+			sorted.erase(std::unique(sorted.begin(), sorted.end(),
+				[&](const ValueType* a, const ValueType* b) { return !less(*a, *b); }), sorted.end());
+			auto values = std::views::transform(sorted, [](const ValueType* value) -> const ValueType& { return *value; });
+			buildFromSorted(values.begin(), sorted.size());
+		}
+	}
+
+	//builds a perfectly balanced tree from n strictly increasing elements in O(n);
+	//every level is black except an incomplete bottom level, which is red
+	template<class InputIt>
+	void buildFromSorted(InputIt first, size_t n)
+	{
+		size_t red_level = 0;
+		for (size_t m = n; m > 0; m = (m - 1) / 2) {
+			++red_level;
+		}
+		try {
+			root = buildSubtree(first, n, 0, red_level);
+		}
+		catch (...) {
+			clear();
+			throw;
+		}
+		if (root) root->parent = nullptr;
+		_size = n;
+	}
+
+	//copies the shape and colors of other node for node, no rebalancing
+	void cloneFrom(const RBTree& other)
+	{
+		try {
+			root = cloneSubtree(other.root);
+		}
+		catch (...) {
+			clear();
+			throw;
+		}
+		if (root) root->parent = nullptr;
+		_size = other._size;
+	}
+
+private:
+	//append to the in-order thread, nodes have to arrive in key order
+	void appendToThread(Node* node) {
+		node->prev = tail;
+		node->next = nullptr;
+		if (tail) tail->next = node;
+		else head = node;
+		tail = node;
+	}
+
+	//nodes are created in key order and threaded right away,
+	//so clear() can clean up after an exception
+	template<class InputIt>
+	Node* buildSubtree(InputIt& it, size_t n, size_t level, size_t red_level)
+	{
+		if (n == 0) return nullptr;
+		size_t left_count = (n - 1) / 2;
+		Node* left = buildSubtree(it, left_count, level + 1, red_level);
+
+		Node* node = pool.create(*it);
+		++it;
+		appendToThread(node);
+		node->color = (level == red_level) ? RED : BLACK;
+		node->left = left;
+		if (left) left->parent = node;
+
+		node->right = buildSubtree(it, n - 1 - left_count, level + 1, red_level);
+		if (node->right) node->right->parent = node;
+		update(node);
+		return node;
+	}
+
+	Node* cloneSubtree(const Node* source)
+	{
+		if (source == nullptr) return nullptr;
+		Node* left = cloneSubtree(source->left);
+
+		Node* node = pool.create(source->value);
+		appendToThread(node);
+		node->color = source->color;
+		node->left = left;
+		if (left) left->parent = node;
+
+		node->right = cloneSubtree(source->right);
+		if (node->right) node->right->parent = node;
+		update(node);
+		return node;
+	}
+
 public:
 
 	class Iterator
 	{
+		friend class RBTree;
 	private:
 		Node* node = nullptr;
 		RBTree* tree = nullptr;
@@ -263,83 +934,39 @@ public:
 		Iterator& operator=(const Iterator& other)
 		{
 			node = other.node;
-            tree = other.tree;
+			tree = other.tree;
 			return *this;
 		}
 
-		bool operator==(const Iterator& other) { return other.node == node; }
+		bool operator==(const Iterator& other) const { return other.node == node; }
+
+		bool operator!=(const Iterator& other) const { return !(*this == other); }
 
-		bool operator!=(const Iterator& other) { return !(*this == other); }
+		//steps follow the in-order thread: no key copies, no comparisons
 
 		Iterator& operator++()
 		{
-			if (node->right != nullptr) {
-				node = tree->min_node(node->right);
-			}
-			else {
-				KeyType key = node->key;
-				node = node->parent;
-				while (node != nullptr && key_compare().operator()(node->key, key)) {
-					node = node->parent;
-				}
-			}
-
+			node = node->next;
 			return *this;
 		}
 
 		Iterator& operator--()
 		{
-			if (node == nullptr) {
-				node = tree->max_node(tree->root);
-			}
-			else if (node->left != nullptr) {
-				node = tree->max_node(node->left);
-			}
-			else {
-				KeyType key = node->key;
-				node = node->parent;
-				while (key_compare().operator()(key, node->key) && node != nullptr) {
-					node = node->parent;
-				}
-			}
-
+			node = node ? node->prev : tree->tail;
 			return *this;
 		}
 
 		Iterator operator++(int)
 		{
 			auto it = *this;
-			if (node->right != nullptr) {
-				node = tree->min_node(node->right);
-			}
-			else {
-				KeyType key = node->key;
-				node = node->parent;
-				while (key_compare().operator()(node->key, key) && node != nullptr) {
-					node = node->parent;
-				}
-			}
-
-			return *it;
+			++*this;
+			return it;
 		}
 
 		Iterator operator--(int)
 		{
 			auto it = *this;
-			if (node == nullptr) {
-				node = tree->max_node(tree->root);
-			}
-			else if (node->left != nullptr) {
-				node = tree->max_node(node->left);
-			}
-			else {
-				KeyType key = node->key;
-				node = node->parent;
-				while (key_compare().operator()(key, node->key) && node != nullptr) {
-					node = node->parent;
-				}
-			}
-
+			--*this;
 			return it;
 		}
 
@@ -350,6 +977,7 @@ public:
 
 	class Const_Iterator
 	{
+		friend class RBTree;
 	private:
 		Node* node = nullptr;
 		RBTree* tree = nullptr;
@@ -363,83 +991,37 @@ public:
 		Const_Iterator& operator=(const Const_Iterator& other)
 		{
 			node = other.node;
-            tree = other.tree;
+			tree = other.tree;
 			return *this;
 		}
 
-		bool operator==(const Const_Iterator& other) { return other.node == node; }
+		bool operator==(const Const_Iterator& other) const { return other.node == node; }
 
-		bool operator!=(const Const_Iterator& other) { return !(*this == other); }
+		bool operator!=(const Const_Iterator& other) const { return !(*this == other); }
 
 		Const_Iterator& operator++()
 		{
-			if (node->right != nullptr) {
-				node = tree->min_node(node->right);
-			}
-			else {
-				KeyType key = node->key;
-				node = node->parent;
-				while (node != nullptr && key_compare().operator()(node->key, key)) {
-					node = node->parent;
-				}
-			}
-
+			node = node->next;
 			return *this;
 		}
 
 		Const_Iterator& operator--()
 		{
-			if (node == nullptr) {
-				node = tree->max_node(tree->root);
-			}
-			else if (node->left != nullptr) {
-				node = tree->max_node(node->left);
-			}
-			else {
-				KeyType key = node->key;
-				node = node->parent;
-				while (key_compare().operator()(key, node->key) && node != nullptr) {
-					node = node->parent;
-				}
-			}
-
+			node = node ? node->prev : tree->tail;
 			return *this;
 		}
 
 		Const_Iterator operator++(int)
 		{
 			auto it = *this;
-			if (node->right != nullptr) {
-				node = tree->min_node(node->right);
-			}
-			else {
-				KeyType key = node->key;
-				node = node->parent;
-				while (key_compare().operator()(node->key, key) && node != nullptr) {
-					node = node->parent;
-				}
-			}
-
-			return *it;
+			++*this;
+			return it;
 		}
 
 		Const_Iterator operator--(int)
 		{
 			auto it = *this;
-			if (node == nullptr) {
-				node = tree->max_node(tree->root);
-			}
-			else if (node->left != nullptr) {
-				node = tree->max_node(node->left);
-			}
-			else {
-				KeyType key = node->key;
-				node = node->parent;
-				while (key_compare().operator()(key, node->key) && node != nullptr) {
-					node = node->parent;
-				}
-			}
-
+			--*this;
 			return it;
 		}
 
@@ -463,274 +1045,251 @@ public:
 		Reverse_Iterator& operator=(const Reverse_Iterator& other)
 		{
 			node = other.node;
-            tree = other.tree;
+			tree = other.tree;
 			return *this;
 		}
 
-		bool operator==(const Reverse_Iterator& other) { return other.node == node; }
+		bool operator==(const Reverse_Iterator& other) const { return other.node == node; }
 
-		bool operator!=(const Reverse_Iterator& other) { return !(*this == other); }
+		bool operator!=(const Reverse_Iterator& other) const { return !(*this == other); }
 
-		Reverse_Iterator& operator--()
+		Reverse_Iterator& operator++()
 		{
-			if (node->right != nullptr) {
-				node = tree->min_node(node->right);
-			}
-			else {
-				KeyType key = node->key;
-				node = node->parent;
-				while (key_compare().operator()(node->key, key) && node != nullptr) {
-					node = node->parent;
-				}
-			}
-
+			node = node->prev;
 			return *this;
 		}
 
-		Reverse_Iterator& operator++()
+		Reverse_Iterator& operator--()
 		{
-			if (node == nullptr) {
-				node = tree->max_node(tree->root);
-			}
-			else if (node->left != nullptr) {
-				node = tree->max_node(node->left);
-			}
-			else {
-				KeyType key = node->key;
-				node = node->parent;
-                while (node != nullptr && key_compare().operator()(key, node->key)) {
-					node = node->parent;
-				}
-			}
-
+			node = node ? node->next : tree->head;
 			return *this;
 		}
 
-		Reverse_Iterator operator--(int)
+		Reverse_Iterator operator++(int)
 		{
 			auto it = *this;
-			if (node->right != nullptr) {
-				node = tree->min_node(node->right);
-			}
-			else {
-				KeyType key = node->key;
-				node = node->parent;
-				while (key_compare().operator()(node->key, key) && node != nullptr) {
-					node = node->parent;
-				}
-			}
-
-			return *it;
+			++*this;
+			return it;
 		}
 
-		Reverse_Iterator operator++(int)
+		Reverse_Iterator operator--(int)
 		{
 			auto it = *this;
-			if (node == nullptr) {
-                node = tree->max_node(tree->root);
-			}
-			else if (node->left != nullptr) {
-				node = tree->max_node(node->left);
-			}
-			else {
-				KeyType key = node->key;
-				node = node->parent;
-				while (key_compare().operator()(node->key, key) && node != nullptr) {
-					node = node->parent;
-				}
-			}
-
+			--*this;
 			return it;
 		}
 
-		ValueType& operator*() { return this->node->value; }
+		ValueType& operator*() { return node->value; }
 
-		ValueType* operator->() { return &this->node->value; }
+		ValueType* operator->() { return &node->value; }
 	};
 
 	class L_Iterator
 	{
 	private:
-		typename std::list<Node*>::iterator it;
+		Node* node = nullptr;
+		RBTree* tree = nullptr;
 
 	public:
 		L_Iterator() { }
 
-		L_Iterator(typename std::list<Node*>::iterator it) : it(it) { }
+		L_Iterator(Node* node, RBTree* tree) : node(node), tree(tree) { }
 
-		L_Iterator(const L_Iterator& iter) : it(iter.it) { }
+		L_Iterator(const L_Iterator& iter) : node(iter.node), tree(iter.tree) { }
 
 		L_Iterator& operator=(const L_Iterator& other)
 		{
-			it = other.it;
+			node = other.node;
+			tree = other.tree;
 			return *this;
 		}
 
-		bool operator==(const L_Iterator& other) { return other.it == it; }
+		bool operator==(const L_Iterator& other) const { return other.node == node; }
 
-		bool operator!=(const L_Iterator& other) { return !(*this == other); }
+		bool operator!=(const L_Iterator& other) const { return !(*this == other); }
 
 		L_Iterator& operator++()
 		{
-			++it;
+			node = node->next;
 			return *this;
 		}
 
 		L_Iterator& operator--()
 		{
-			--it;
+			node = node ? node->prev : tree->tail;
 			return *this;
 		}
 
 		L_Iterator operator++(int)
 		{
 			auto iter = *this;
-			++it;
+			++*this;
 			return iter;
 		}
 
 		L_Iterator operator--(int)
 		{
 			auto iter = *this;
-			--it;
+			--*this;
 			return iter;
 		}
 
-		ValueType& operator*() { return (*it)->value; }
+		ValueType& operator*() { return node->value; }
 
-		ValueType* operator->() { return &(*it)->value; }
+		ValueType* operator->() { return &node->value; }
 	};
 
 	class Const_L_Iterator
 	{
 	private:
-		typename std::list<Node*>::const_iterator it;
+		const Node* node = nullptr;
+		const RBTree* tree = nullptr;
 
 	public:
 		Const_L_Iterator() { }
 
-		Const_L_Iterator(typename std::list<Node*>::const_iterator it) : it(it) { }
+		Const_L_Iterator(const Node* node, const RBTree* tree) : node(node), tree(tree) { }
 
-		Const_L_Iterator(const Const_L_Iterator& iter) : it(iter.it) { }
+		Const_L_Iterator(const Const_L_Iterator& iter) : node(iter.node), tree(iter.tree) { }
 
 		Const_L_Iterator& operator=(const Const_L_Iterator& other)
 		{
-			it = other.it;
+			node = other.node;
+			tree = other.tree;
 			return *this;
 		}
 
-		bool operator==(const Const_L_Iterator& other) { return other.it == it; }
+		bool operator==(const Const_L_Iterator& other) const { return other.node == node; }
 
-		bool operator!=(const Const_L_Iterator& other) { return !(*this == other); }
+		bool operator!=(const Const_L_Iterator& other) const { return !(*this == other); }
 
 		Const_L_Iterator& operator++()
 		{
-			++it;
+			node = node->next;
 			return *this;
 		}
 
 		Const_L_Iterator& operator--()
 		{
-			--it;
+			node = node ? node->prev : tree->tail;
 			return *this;
 		}
 
 		Const_L_Iterator operator++(int)
 		{
 			auto iter = *this;
-			++it;
+			++*this;
 			return iter;
 		}
 
 		Const_L_Iterator operator--(int)
 		{
 			auto iter = *this;
-			--it;
+			--*this;
 			return iter;
 		}
 
-		const_reference& operator*() { return (*it)->value; }
+		const_reference operator*() { return node->value; }
 
-		const ValueType* operator->() { return &(*it)->value; }
+		const ValueType* operator->() { return &node->value; }
 	};
 
 	class reverse_l_iterator
 	{
 	private:
-		typename std::list<Node*>::reverse_iterator it;
+		Node* node = nullptr;
+		RBTree* tree = nullptr;
 
 	public:
 		reverse_l_iterator() { }
 
-		reverse_l_iterator(typename std::list<Node*>::reverse_iterator it) : it(it) { }
+		reverse_l_iterator(Node* node, RBTree* tree) : node(node), tree(tree) { }
 
-		reverse_l_iterator(const reverse_l_iterator& iter) : it(iter.it) { }
+		reverse_l_iterator(const reverse_l_iterator& iter) : node(iter.node), tree(iter.tree) { }
 
 		reverse_l_iterator& operator=(const reverse_l_iterator& other)
 		{
-			it = other.it;
+			node = other.node;
+			tree = other.tree;
 			return *this;
 		}
 
-		bool operator==(const reverse_l_iterator& other) { return other.it == it; }
+		bool operator==(const reverse_l_iterator& other) const { return other.node == node; }
 
-		bool operator!=(const reverse_l_iterator& other) { return !(*this == other); }
+		bool operator!=(const reverse_l_iterator& other) const { return !(*this == other); }
 
 		reverse_l_iterator& operator++()
 		{
-			++it;
+			node = node->prev;
 			return *this;
 		}
 
 		reverse_l_iterator& operator--()
 		{
-			--it;
+			node = node ? node->next : tree->head;
 			return *this;
 		}
 
 		reverse_l_iterator operator++(int)
 		{
 			auto iter = *this;
-			++it;
+			++*this;
 			return iter;
 		}
 
 		reverse_l_iterator operator--(int)
 		{
 			auto iter = *this;
-			--it;
+			--*this;
 			return iter;
 		}
 
-		ValueType& operator*() { return (*it)->value; }
+		ValueType& operator*() { return node->value; }
 
-		ValueType* operator->() { return &(*it)->value; }
+		ValueType* operator->() { return &node->value; }
 	};
 
 
-	iterator begin() { return iterator(min_node(root), this); }
+	//pair of list iterators usable in range-based for
+	class Range
+	{
+	private:
+		l_iterator first;
+		l_iterator last;
+	public:
+		Range(l_iterator first, l_iterator last) : first(first), last(last) { }
+
+		l_iterator begin() const { return first; }
+
+		l_iterator end() const { return last; }
+
+		bool empty() const { return first == last; }
+	};
+
+
+	iterator begin() { return iterator(head, this); }
 
 	iterator end() { return iterator(nullptr, this); }
 
-	Const_Iterator cbegin() { return Const_Iterator(min_node(root), this); }
+	Const_Iterator cbegin() { return Const_Iterator(head, this); }
 
 	Const_Iterator cend() { return Const_Iterator(nullptr, this); }
 
-	Reverse_Iterator rbegin() { return Reverse_Iterator(max_node(root), this); }
+	Reverse_Iterator rbegin() { return Reverse_Iterator(tail, this); }
 
 	Reverse_Iterator rend() { return Reverse_Iterator(nullptr, this); }
 
-	Const_L_Iterator clbegin() { return Const_L_Iterator(list.cbegin()); }
+	Const_L_Iterator clbegin() { return Const_L_Iterator(head, this); }
 
-	Const_L_Iterator clend() { return Const_L_Iterator(list.cend()); }
+	Const_L_Iterator clend() { return Const_L_Iterator(nullptr, this); }
 
-	l_iterator l_begin() { return l_iterator(list.begin()); }
+	l_iterator l_begin() { return l_iterator(head, this); }
 
-	l_iterator l_end() { return l_iterator(list.end()); }
+	l_iterator l_end() { return l_iterator(nullptr, this); }
 
-	reverse_l_iterator rl_begin() { return reverse_l_iterator(list.rbegin()); }
+	reverse_l_iterator rl_begin() { return reverse_l_iterator(tail, this); }
 
-	reverse_l_iterator rl_end() { return reverse_l_iterator(list.rend()); }
+	reverse_l_iterator rl_end() { return reverse_l_iterator(nullptr, this); }
 
 
 private:
@@ -755,6 +1314,8 @@ private:
 
 		x->right = node;
 		if (node != nullptr) node->parent = x;
+		update(node);
+		update(x);
 	}
 
 	void rotateLeft(Node* node)
@@ -777,6 +1338,8 @@ private:
 		}
 		y->left = node;
 		if (node != nullptr) node->parent = y;
+		update(node);
+		update(y);
 	}
 
 	void insert_fixup(Node* node)
@@ -853,80 +1416,372 @@ protected:
 				std::cout << " ";
 			}
 
-			if (node->color == RED) std::cout << "\033[31m" << node->key << "-" << node->pair.second << "\033[0m";
-			else std::cout << node->key << "-" << node->pair.second << "\n";
+			if (node->color == RED) std::cout << "\033[31m" << keyOf(node) << "\033[0m\n";
+			else std::cout << keyOf(node) << "\n";
 
 			printTree(node->left, space);
 		}
 	}
 private:
 
-	void delete_fixup(Node* x)
+	static bool isBlack(Node* node) { return node == nullptr || node->color == BLACK; }
+
+	void delete_fixup(Node* x, Node* x_parent)
 	{
-		if (!x) return;
-		while (x != root && x->color == BLACK) {
-			if (x == x->parent->left) {
-				Node* w = x->parent->right;
+		while (x != root && isBlack(x)) {
+			if (x == x_parent->left) {
+				Node* w = x_parent->right;
 				if (w->color == RED) {
 					w->color = BLACK;
-					x->parent->color = RED;
-					rotateLeft(x->parent);
-					w = x->parent->right;
+					x_parent->color = RED;
+					rotateLeft(x_parent);
+					w = x_parent->right;
 				}
-				if (w->left->color == BLACK && w->right->color == BLACK) {
+				if (isBlack(w->left) && isBlack(w->right)) {
 					w->color = RED;
-					x = x->parent;
+					x = x_parent;
+					x_parent = x->parent;
 				}
 				else {
-					if (w->right->color == BLACK) {
+					if (isBlack(w->right)) {
 						w->left->color = BLACK;
 						w->color = RED;
 						rotateRight(w);
-						w = x->parent->right;
+						w = x_parent->right;
 					}
-					w->color = x->parent->color;
-					x->parent->color = BLACK;
+					w->color = x_parent->color;
+					x_parent->color = BLACK;
 					w->right->color = BLACK;
-					rotateLeft(x->parent);
+					rotateLeft(x_parent);
 					x = root;
 				}
 			}
 			else {
-				Node* w = x->parent->left;
+				Node* w = x_parent->left;
 				if (w->color == RED) {
 					w->color = BLACK;
-					x->parent->color = RED;
-					rotateRight(x->parent);
-					w = x->parent->left;
+					x_parent->color = RED;
+					rotateRight(x_parent);
+					w = x_parent->left;
 				}
-				if (w->right->color == BLACK && w->left->color == BLACK) {
+				if (isBlack(w->right) && isBlack(w->left)) {
 					w->color = RED;
-					x = x->parent;
+					x = x_parent;
+					x_parent = x->parent;
 				}
 				else {
-					if (w->left->color == BLACK) {
+					if (isBlack(w->left)) {
 						w->right->color = BLACK;
 						w->color = RED;
 						rotateLeft(w);
-						w = x->parent->left;
+						w = x_parent->left;
 					}
-					w->color = x->parent->color;
-					x->parent->color = BLACK;
+					w->color = x_parent->color;
+					x_parent->color = BLACK;
 					w->left->color = BLACK;
-					rotateRight(x->parent);
+					rotateRight(x_parent);
 					x = root;
 				}
 			}
 		}
-		x->color = BLACK;
+		if (x) x->color = BLACK;
 	}
 
-	void deleteTree(Node* node)
+	//***********join and split*******************//
+
+	//a detached subtree and its black height: black nodes on any path from
+	//the root down to null, root included. the root is always black
+	struct Subtree
 	{
-		if (node && node != nullptr) {
-			deleteTree(node->left);
-			deleteTree(node->right);
-			delete node;
+		Node* root = nullptr;
+		size_t height = 0;
+	};
+
+	struct SplitResult
+	{
+		Subtree less;
+		Node* equal = nullptr;	//node with the split key, detached, or null
+		Subtree greater;
+	};
+
+	enum class SetOperation { Union, Intersection, Difference };
+
+	//below this many nodes a subproblem is not worth a new task
+	static constexpr size_t parallel_grain = 4096;
+
+	static size_t blackHeight(const Node* node)
+	{
+		size_t height = 0;
+		for (; node != nullptr; node = node->left) {
+			if (node->color == BLACK) ++height;
+		}
+		return height;
+	}
+
+	//cut a child off its black parent of the given black height
+	static Subtree detachChild(Node* child, size_t parent_height)
+	{
+		Subtree result{ child, parent_height - 1 };
+		if (child) {
+			child->parent = nullptr;
+			if (child->color == RED) {
+				child->color = BLACK;
+				++result.height;
+			}
+		}
+		return result;
+	}
+
+	static Node* attach(Node* left, Node* node, Node* right, bool color)
+	{
+		node->left = left;
+		node->right = right;
+		if (left) left->parent = node;
+		if (right) right->parent = node;
+		node->color = color;
+		update(node);
+		return node;
+	}
+
+	//rotations for subtrees that are not hooked into root, return the new top
+	static Node* rotateLeftDetached(Node* node)
+	{
+		Node* y = node->right;
+		node->right = y->left;
+		if (y->left) y->left->parent = node;
+		y->left = node;
+		node->parent = y;
+		update(node);
+		update(y);
+		return y;
+	}
+
+	static Node* rotateRightDetached(Node* node)
+	{
+		Node* x = node->left;
+		node->left = x->right;
+		if (x->right) x->right->parent = node;
+		x->right = node;
+		node->parent = x;
+		update(node);
+		update(x);
+		return x;
+	}
+
+	//l is taller: walk down its right spine to a black node of r's height,
+	//hang k there and repair a red-red pair on the way back up
+	static Node* joinRight(Node* l, size_t l_height, Node* k, Node* r, size_t r_height)
+	{
+		if (l_height == r_height && isBlack(l)) {
+			return attach(l, k, r, RED);
+		}
+		Node* right = joinRight(l->right, l_height - (l->color == BLACK), k, r, r_height);
+		attach(l->left, l, right, l->color);
+		if (l->color == BLACK && !isBlack(right) && !isBlack(right->right)) {
+			right->right->color = BLACK;
+			return rotateLeftDetached(l);
+		}
+		return l;
+	}
+
+	static Node* joinLeft(Node* l, size_t l_height, Node* k, Node* r, size_t r_height)
+	{
+		if (l_height == r_height && isBlack(r)) {
+			return attach(l, k, r, RED);
+		}
+		Node* left = joinLeft(l, l_height, k, r->left, r_height - (r->color == BLACK));
+		attach(left, r, r->right, r->color);
+		if (r->color == BLACK && !isBlack(left) && !isBlack(left->left)) {
+			left->left->color = BLACK;
+			return rotateRightDetached(r);
+		}
+		return r;
+	}
+
+	//all keys of l < k < all keys of r, O(|height difference| + 1)
+	static Subtree join(Subtree l, Node* k, Subtree r)
+	{
+		if (l.height == r.height) {
+			attach(l.root, k, r.root, BLACK)->parent = nullptr;
+			return Subtree{ k, l.height + 1 };
+		}
+		Subtree result;
+		if (l.height > r.height) {
+			result = Subtree{ joinRight(l.root, l.height, k, r.root, r.height), l.height };
+		}
+		else {
+			result = Subtree{ joinLeft(l.root, l.height, k, r.root, r.height), r.height };
+		}
+		result.root->parent = nullptr;
+		if (result.root->color == RED) {
+			result.root->color = BLACK;
+			++result.height;
+		}
+		return result;
+	}
+
+	//join without a middle node: the largest node of l is taken out for it
+	static Subtree join2(Subtree l, Subtree r)
+	{
+		if (l.root == nullptr) return r;
+		if (r.root == nullptr) return l;
+		Node* last = nullptr;
+		Subtree rest = splitLast(l, last);
+		return join(rest, last, r);
+	}
+
+	static Subtree splitLast(Subtree t, Node*& last)
+	{
+		Node* node = t.root;
+		Subtree left = detachChild(node->left, t.height);
+		Subtree right = detachChild(node->right, t.height);
+		if (right.root == nullptr) {
+			last = node;
+			return left;
+		}
+		Subtree rest = splitLast(right, last);
+		return join(left, node, rest);
+	}
+
+	//O(log n), the pieces reuse the nodes of t
+	SplitResult split(Subtree t, const KeyType& key) const
+	{
+		if (t.root == nullptr) return SplitResult();
+		Node* node = t.root;
+		Subtree left = detachChild(node->left, t.height);
+		Subtree right = detachChild(node->right, t.height);
+		if (comp(key, keyOf(node))) {
+			SplitResult result = split(left, key);
+			result.greater = join(result.greater, node, right);
+			return result;
+		}
+		if (comp(keyOf(node), key)) {
+			SplitResult result = split(right, key);
+			result.less = join(left, node, result.less);
+			return result;
+		}
+		node->left = node->right = nullptr;
+		return SplitResult{ left, node, right };
+	}
+
+	//divide and conquer over the root of a: split b around it, solve both
+	//halves (the left one as a separate task near the top), join the results.
+	//removed nodes are collected in garbage and destroyed by the caller
+	Subtree combine(Subtree a, Subtree b, SetOperation op, size_t depth, std::vector<Node*>& garbage) const
+	{
+		if (a.root == nullptr) {
+			if (op == SetOperation::Union) return b;
+			if (b.root) garbage.push_back(b.root);
+			return Subtree();
+		}
+		if (b.root == nullptr) {
+			if (op != SetOperation::Intersection) return a;
+			garbage.push_back(a.root);
+			return Subtree();
+		}
+
+		Node* node = a.root;
+		bool parallel = depth > 0 && node->size + b.root->size >= parallel_grain;
+		Subtree a_left = detachChild(node->left, a.height);
+		Subtree a_right = detachChild(node->right, a.height);
+		node->left = node->right = nullptr;
+		SplitResult parts = split(b, keyOf(node));
+
+		Subtree left, right;
+		if (parallel) {
+			std::vector<Node*> left_garbage;
+			auto task = std::async(std::launch::async | std::launch::deferred, [&]() {
+				return combine(a_left, parts.less, op, depth - 1, left_garbage);
+			});
+			right = combine(a_right, parts.greater, op, depth - 1, garbage);
+			left = task.get();
+			garbage.insert(garbage.end(), left_garbage.begin(), left_garbage.end());
+		}
+		else {
+			left = combine(a_left, parts.less, op, 0, garbage);
+			right = combine(a_right, parts.greater, op, 0, garbage);
+		}
+
+		bool keep = op == SetOperation::Union || (op == SetOperation::Intersection) == (parts.equal != nullptr);
+		if (parts.equal) garbage.push_back(parts.equal);
+		if (keep) return join(left, node, right);
+		garbage.push_back(node);
+		return join2(left, right);
+	}
+
+	void combineWith(RBTree& other, SetOperation op, size_t threads)
+	{
+		if (&other == this) {
+			if (op == SetOperation::Difference) clear();
+			return;
+		}
+		if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+		size_t depth = 0;
+		for (size_t parts = 1; parts < threads; parts *= 2) {
+			++depth;
+		}
+
+		pool.adopt(other.pool);
+		std::vector<Node*> garbage;
+		Subtree result = combine(Subtree{ root, blackHeight(root) },
+								 Subtree{ other.root, blackHeight(other.root) }, op, depth, garbage);
+		other.root = other.head = other.tail = nullptr;
+		other._size = 0;
+
+		root = result.root;
+		_size = sizeOf(root);
+		head = tail = nullptr;
+		if (root) {
+			auto ends = threadSubtree(root, depth);
+			head = ends.first;
+			tail = ends.second;
+		}
+		for (Node* node : garbage) {
+			destroySubtree(node);
+		}
+	}
+
+	//relinks prev/next inside a subtree in order, returns its first and last node
+	static std::pair<Node*, Node*> threadSubtree(Node* node, size_t depth)
+	{
+		std::pair<Node*, Node*> left(node, node), right(node, node);
+		auto threadLeft = [&]() {
+			if (node->left) left = threadSubtree(node->left, depth ? depth - 1 : 0);
+		};
+		std::future<void> task;
+		if (depth > 0 && node->size >= parallel_grain) {
+			task = std::async(std::launch::async | std::launch::deferred, threadLeft);
+		}
+		else {
+			threadLeft();
+		}
+		if (node->right) right = threadSubtree(node->right, depth ? depth - 1 : 0);
+		if (task.valid()) task.get();
+
+		node->prev = node->left ? left.second : nullptr;
+		node->next = node->right ? right.first : nullptr;
+		if (node->left) left.second->next = node;
+		if (node->right) right.first->prev = node;
+		return std::make_pair(left.first, right.second);
+	}
+
+	void destroySubtree(Node* node)
+	{
+		if (node == nullptr) return;
+		destroySubtree(node->left);
+		destroySubtree(node->right);
+		pool.destroy(node);
+	}
+
+	//run node destructors, the storage itself goes back with the slabs
+	void destroyNodes()
+	{
+		if constexpr (!std::is_trivially_destructible_v<Node>) {
+			for (Node* node = head; node != nullptr;) {
+				Node* next = node->next;
+				pool.destroyInPlace(node);
+				node = next;
+			}
 		}
 	}
 
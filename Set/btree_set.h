@@ -0,0 +1,40 @@
+#pragma once
+
+#include "set.h"
+#include "BTree.h"
+
+//Set interface over the B+tree engine.
+template<class Key, class Compare = std::less<Key>, class Allocator = std::allocator<Key>>
+class BTreeSet : public BTree<SetTraits<Key, Compare, Allocator>>
+{
+	using Tree               = BTree<SetTraits<Key, Compare, Allocator>>;
+	using ValueType          = typename SetTraits<Key, Compare, Allocator>::value;
+	using KeyType            = typename SetTraits<Key, Compare, Allocator>::key;
+
+public:
+	using iterator           = typename Tree::Const_Iterator;
+
+	BTreeSet() { }
+
+	explicit BTreeSet(const Allocator& alloc) : Tree(alloc) { }
+
+	BTreeSet(const BTreeSet& other) : Tree(other.get_allocator())
+	{
+		this->cloneFrom(other);
+	}
+
+	BTreeSet(std::initializer_list<ValueType> init)
+	{
+		for (const auto& it : init) {
+			insert(it);
+		}
+	}
+
+	~BTreeSet() { }
+
+	std::pair<iterator, bool> insert(const ValueType& value)
+	{
+		return Tree::insert(value);
+	}
+
+};
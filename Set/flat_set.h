@@ -0,0 +1,181 @@
+#pragma once
+
+#include "../vector/my_vector.h"
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <utility>
+
+namespace flat_detail
+{
+	//branchless binary search: the probe compiles to a conditional move and
+	//the trip count depends only on n, so nothing is left to mispredict.
+	//returns the first index i with !pred(first[i]), pred must partition the range
+	template<class T, class Pred>
+	size_t partition_point(const T* first, size_t n, Pred pred)
+	{
+		if (n == 0) return 0;
+		const T* base = first;
+		while (n > 1) {
+			size_t half = n / 2;
+			base = pred(base[half]) ? base + half : base;
+			n -= half;
+		}
+		return (base - first) + pred(*base);
+	}
+
+	//sorts by less keeping the first of equal elements and drops the others,
+	//returns the new end
+	template<class T, class Less>
+	T* sort_unique(T* first, T* last, Less less)
+	{
+		std::stable_sort(first, last, less);
+		return std::unique(first, last, [&](const T& a, const T& b) { return !less(a, b); });
+	}
+
+	template<class T>
+	void insert_at(vector<T>& v, size_t pos, T value)
+	{
+		v.push_back(std::move(value));
+		std::rotate(&v[pos], &v[v.size() - 1], &v[0] + v.size());
+	}
+
+	template<class T>
+	void erase_at(vector<T>& v, size_t pos)
+	{
+		std::move(&v[pos] + 1, &v[0] + v.size(), &v[pos]);
+		v.pop_back();
+	}
+}
+
+//sorted set in one contiguous array. lookups are branchless binary searches,
+//iteration is a pointer walk; single inserts and erases shift the tail, so
+//prefer the bulk insert(first, last), which sorts the new keys and merges once.
+template<class Key, class Compare = std::less<Key>>
+class flat_set
+{
+	vector<Key> keys;
+	Compare comp;
+
+public:
+	using iterator = const Key*;
+
+	flat_set() { }
+
+	explicit flat_set(const Compare& compare) : comp(compare) { }
+
+	template<class InputIt>
+	flat_set(InputIt first, InputIt last)
+	{
+		insert(first, last);
+	}
+
+	flat_set(std::initializer_list<Key> init)
+	{
+		insert(init.begin(), init.end());
+	}
+
+	iterator begin() const { return keys.empty() ? nullptr : &keys[0]; }
+
+	iterator end() const { return begin() + keys.size(); }
+
+	size_t size() const { return keys.size(); }
+
+	bool empty() const { return keys.empty(); }
+
+	void clear() { keys.clear(); }
+
+	void reserve(size_t count) { keys.reserve(count); }
+
+	iterator lower_bound(const Key& key) const
+	{
+		return begin() + lowerIndex(key);
+	}
+
+	iterator upper_bound(const Key& key) const
+	{
+		return begin() + flat_detail::partition_point(begin(), size(),
+			[&](const Key& k) { return !comp(key, k); });
+	}
+
+	iterator find(const Key& key) const
+	{
+		size_t index = lowerIndex(key);
+		return (index < size() && !comp(key, keys[index])) ? begin() + index : end();
+	}
+
+	bool contains(const Key& key) const { return find(key) != end(); }
+
+	size_t count(const Key& key) const { return contains(key) ? 1 : 0; }
+
+	std::pair<iterator, bool> insert(const Key& key)
+	{
+		size_t index = lowerIndex(key);
+		if (index < size() && !comp(key, keys[index])) {
+			return std::make_pair(begin() + index, false);
+		}
+		flat_detail::insert_at(keys, index, key);
+		return std::make_pair(begin() + index, true);
+	}
+
+	//O(n + k log k) for k new keys; keys already present are kept
+	template<class InputIt>
+	void insert(InputIt first, InputIt last)
+	{
+		vector<Key> incoming;
+		for (; first != last; ++first) {
+			incoming.push_back(*first);
+		}
+		if (incoming.empty()) return;
+		auto less = [&](const Key& a, const Key& b) { return comp(a, b); };
+		size_t count = flat_detail::sort_unique(&incoming[0], &incoming[0] + incoming.size(), less) - &incoming[0];
+
+		size_t n = size();
+		if (n == 0 || comp(keys[n - 1], incoming[0])) {		//pure append
+			keys.reserve(n + count);
+			for (size_t j = 0; j < count; ++j) {
+				keys.push_back(std::move(incoming[j]));
+			}
+			return;
+		}
+
+		vector<Key> merged;
+		merged.reserve(n + count);
+		size_t i = 0, j = 0;
+		while (i < n && j < count) {
+			if (comp(incoming[j], keys[i])) {
+				merged.push_back(std::move(incoming[j++]));
+			}
+			else {
+				if (!comp(keys[i], incoming[j])) ++j;		//already present
+				merged.push_back(std::move(keys[i++]));
+			}
+		}
+		for (; i < n; ++i) merged.push_back(std::move(keys[i]));
+		for (; j < count; ++j) merged.push_back(std::move(incoming[j]));
+		keys.swap(merged);
+	}
+
+	size_t erase(const Key& key)
+	{
+		iterator it = find(key);
+		if (it == end()) return 0;
+		erase(it);
+		return 1;
+	}
+
+	iterator erase(iterator pos)
+	{
+		size_t index = pos - begin();
+		flat_detail::erase_at(keys, index);
+		return begin() + index;
+	}
+
+private:
+	size_t lowerIndex(const Key& key) const
+	{
+		return flat_detail::partition_point(begin(), size(),
+			[&](const Key& k) { return comp(k, key); });
+	}
+};
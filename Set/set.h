@@ -2,59 +2,116 @@
 
 #include "RedBlackTree.h"
 
-template<class Key, class Compare>
+template<class Key, class Compare, class Allocator = std::allocator<Key>>
 class SetTraits
 {
 public:
 	using key = Key;
 	using value = Key;
 	using key_compare = Compare;
+	using allocator_type = Allocator;
+
+	static const key& get_key(const value& v) { return v; }
 };
 
-template<class Key, class Compare = std::less<Key>>
-class Set : public RBTree<SetTraits<Key, Compare>>
+template<class Key, class Compare = std::less<Key>, class Allocator = std::allocator<Key>>
+class Set : public RBTree<SetTraits<Key, Compare, Allocator>>
 {
-	using Tree               = RBTree<SetTraits<Key, Compare>>;
+	using Tree               = RBTree<SetTraits<Key, Compare, Allocator>>;
 	using Node               = typename Tree::Node;
 	using iterator           = typename Tree::Const_Iterator;
 	using reverse_iterator   = typename Tree::Reverse_Iterator;
 	using l_iterator         = typename Tree::l_iterator;
 	using reverse_l_iterator = typename Tree::reverse_l_iterator;
-	using ValueType          = typename SetTraits<Key,Compare>::value;
-	using KeyType            = typename SetTraits<Key,Compare>::key;
+	using ValueType          = typename SetTraits<Key, Compare, Allocator>::value;
+	using KeyType            = typename SetTraits<Key, Compare, Allocator>::key;
 
 public:
 	Set() { }
 
-	Set(const Set& other) 
+	explicit Set(const Allocator& alloc) : Tree(alloc) { }
+
+	Set(const Set& other) : Tree(other.get_allocator())
 	{
-		for (const auto& it : other.list) {
-			insert(it->value);
-		}
+		this->cloneFrom(other);
 	}
 
 	Set(std::initializer_list<ValueType> init)
 	{
-		for (const auto& it : init) {
-			insert(it);
-		}
+		this->assignRange(init.begin(), init.end());
+	}
+
+	//O(n) for sorted input, O(n log n) otherwise
+	template<class InputIt>
+	Set(InputIt first, InputIt last)
+	{
+		this->assignRange(first, last);
 	}
 
 	~Set() { }
 
-	bool contains(const Key& key)
+	std::pair<iterator, bool> insert(const ValueType& value)
 	{
-		if (search(key) != nullptr) {
-			return true;
-		}
-		return false;
+		return Tree::insert(value);
 	}
 
-	std::pair<iterator, bool> insert(const ValueType& value)
+	std::pair<iterator, bool> insert(ValueType&& value)
 	{
-		return Tree::insert(value, value);
+		return Tree::insertUnique(value, std::move(value));
 	}
 
-	
+	//hint is the expected position of the successor of value; a correct
+	//hint skips the descent from the root
+	iterator insert(iterator hint, const ValueType& value)
+	{
+		return Tree::insertUniqueHint(hint, value, value).first;
+	}
+
+	iterator insert(iterator hint, ValueType&& value)
+	{
+		return Tree::insertUniqueHint(hint, value, std::move(value)).first;
+	}
+
+	template<class... Args>
+	std::pair<iterator, bool> emplace(Args&&... args)
+	{
+		return Tree::emplace(std::forward<Args>(args)...);
+	}
+
+	template<class... Args>
+	iterator emplace_hint(iterator hint, Args&&... args)
+	{
+		return Tree::emplaceHint(hint, std::forward<Args>(args)...).first;
+	}
 
 };
+
+//***********parallel set algebra on copies*******************//
+//Set::unite/intersect/subtract work in place and avoid the copies
+
+template<class Key, class Compare, class Allocator>
+Set<Key, Compare, Allocator> set_union(const Set<Key, Compare, Allocator>& a, const Set<Key, Compare, Allocator>& b, size_t threads = 0)
+{
+	Set<Key, Compare, Allocator> result(a);
+	Set<Key, Compare, Allocator> other(b);
+	result.unite(other, threads);
+	return result;
+}
+
+template<class Key, class Compare, class Allocator>
+Set<Key, Compare, Allocator> set_intersection(const Set<Key, Compare, Allocator>& a, const Set<Key, Compare, Allocator>& b, size_t threads = 0)
+{
+	Set<Key, Compare, Allocator> result(a);
+	Set<Key, Compare, Allocator> other(b);
+	result.intersect(other, threads);
+	return result;
+}
+
+template<class Key, class Compare, class Allocator>
+Set<Key, Compare, Allocator> set_difference(const Set<Key, Compare, Allocator>& a, const Set<Key, Compare, Allocator>& b, size_t threads = 0)
+{
+	Set<Key, Compare, Allocator> result(a);
+	Set<Key, Compare, Allocator> other(b);
+	result.subtract(other, threads);
+	return result;
+}
@@ -1,8 +1,12 @@
 #ifndef MY_VECTOR_H
 #define MY_VECTOR_H
 
+#include <cstdint>
 #include <initializer_list>
+#include <limits>
+#include <new>
 #include <stdexcept>
+#include <utility>
 
 template<class T>
 class vector
@@ -25,11 +29,14 @@ public:
     vector(const vector& v) {
         reserve(v.size());
         for (size_t i = 0; i < v.size(); ++i) {
-            new (arr + i) T(v[i]);
+            new (arr + i) T(v.arr[i]);
         }
+        m_size = v.size();
     }
 
-    vector(vector&& v) = default;
+    vector(vector&& v) noexcept {
+        swap(v);
+    }
 
     vector(std::initializer_list<T> init) {
         reserve(init.size());
@@ -49,14 +56,14 @@ public:
 
     ~vector() {
         for (size_t i = 0; i < m_size; ++i) {
-            arr->~T();
+            arr[i].~T();
         }
         delete[] reinterpret_cast<uint8_t*>(arr);
     }
 
 
     size_t max_size() const noexcept {
-        return static_cast<size_t>(pow(2, 64) / sizeof(T));
+        return std::numeric_limits<size_t>::max() / sizeof(T);
     }
 
     void reserve(size_t new_cap) {
@@ -67,7 +74,7 @@ public:
             T* new_arr = reinterpret_cast<T*>(new uint8_t[sizeof(T) * new_cap]);
             //copy object to new arr
             for (size_t i = 0; i < m_size; ++i) {
-                new (new_arr + i) T(arr[i]);	  //make exception safety!!!
+                new (new_arr + i) T(std::move_if_noexcept(arr[i]));	  //make exception safety!!!
             }
             //destruct objects
             for (size_t i = 0; i < m_size; ++i) {
@@ -88,9 +95,10 @@ public:
         for (size_t i = m_size; i < count; ++i) {
             new(arr + i) T(value);
         }
-        if (count < m_size) {
-            m_size = count;
+        for (size_t i = count; i < m_size; ++i) {
+            arr[i].~T();
         }
+        m_size = count;
     }
 
     void push_back(const T& value) {
@@ -103,8 +111,19 @@ public:
         ++m_size;
     }
 
+    void push_back(T&& value) {
+        if (m_size == m_capacity) {
+            size_t new_cap = (m_size ? m_capacity * 2 : 1);
+            reserve(new_cap);
+        }
+
+        new (arr + m_size) T(std::move(value));
+        ++m_size;
+    }
+
     void pop_back() {
         --m_size;
+        arr[m_size].~T();
     }
 
     void assign(size_t count, const T& value) {
@@ -133,17 +152,21 @@ public:
 
     T& operator[](size_t indx) { return arr[indx]; }
 
+    const T& operator[](size_t indx) const { return arr[indx]; }
+
     void operator=(const vector& v) {
+        if (this == &v) return;
         this->clear();
         reserve(v.size());
         for (size_t i = 0; i < v.size(); ++i) {
             new (arr + i) T(v[i]);
         }
+        m_size = v.size();
     }
 
     T& at(size_t indx) {
         if (indx >= m_size) {
-            throw std::out_of_range;
+            throw std::out_of_range("invalid vector subscript");
         }
         return arr[indx];
     }
@@ -155,9 +178,10 @@ public:
     template< class... Args >
     void emplace_back(Args&&... args) {
         if (m_size == m_capacity) {
-            reserve(m_size * 2);
+            reserve(m_size ? m_size * 2 : 1);
         }
         new (arr + m_size) T(std::forward<Args>(args)...);
+        ++m_size;
     }
 
     template< class... Args >